@@ -35,6 +35,7 @@ pub struct MorseConfig {
     pub freq_hz: f32,
     pub waveform_type: MorseWaveformType,
     pub background_static_level: f32,
+    pub channel: MorseChannelParams,
 
     // Telegraph mode parameters
     pub click_sharpness: f32,
@@ -69,6 +70,7 @@ impl Default for MorseConfig {
             freq_hz: audio_defaults.radio_params.freq_hz,
             waveform_type: audio_defaults.radio_params.waveform_type,
             background_static_level: audio_defaults.radio_params.background_static_level,
+            channel: audio_defaults.radio_params.channel,
 
             // Telegraph defaults
             click_sharpness: audio_defaults.telegraph_params.click_sharpness,
@@ -103,6 +105,7 @@ impl MorseConfig {
                 freq_hz: self.freq_hz,
                 waveform_type: self.waveform_type,
                 background_static_level: self.background_static_level,
+                channel: self.channel.clone(),
             },
             telegraph_params: MorseTelegraphParams {
                 click_sharpness: self.click_sharpness,
@@ -172,6 +175,136 @@ pub fn morse_audio_json(text: &str, config_json: &str) -> Result<String, JsValue
         .map_err(|e| JsValue::from_str(&format!("JSON serialization error: {}", e)))
 }
 
+/// Exact element count, duration and sample count of a text as JSON, for presizing buffers
+#[wasm_bindgen]
+pub fn morse_size_json(text: &str, config_json: &str) -> Result<String, JsValue> {
+    let config: MorseConfig = if config_json.trim().is_empty() {
+        MorseConfig::default()
+    } else {
+        serde_json::from_str(config_json)
+            .map_err(|e| JsValue::from_str(&format!("Invalid config JSON: {}", e)))?
+    };
+
+    let size = timing::morse_size(text, &config.to_timing_params(), &config.to_audio_params())
+        .map_err(|e| JsValue::from_str(&e))?;
+
+    serde_json::to_string(&size)
+        .map_err(|e| JsValue::from_str(&format!("JSON serialization error: {}", e)))
+}
+
+/// Render `len` samples of a text's audio from sample `start`, to resume or scrub playback
+#[wasm_bindgen]
+pub fn morse_audio_window(
+    text: &str,
+    config_json: &str,
+    start: usize,
+    len: usize,
+) -> Result<Vec<f32>, JsValue> {
+    let config: MorseConfig = if config_json.trim().is_empty() {
+        MorseConfig::default()
+    } else {
+        serde_json::from_str(config_json)
+            .map_err(|e| JsValue::from_str(&format!("Invalid config JSON: {}", e)))?
+    };
+
+    let elements = timing::morse_timing(text, &config.to_timing_params())
+        .map_err(|e| JsValue::from_str(&e))?;
+    audio::morse_audio_window(&elements, &config.to_audio_params(), start, len)
+        .map_err(|e| JsValue::from_str(&e))
+}
+
+/// Symbols of a text, one byte each, to cache and re-time at any speed
+#[wasm_bindgen]
+pub fn morse_symbols(text: &str) -> Vec<u8> {
+    timing::MorseSymbolIter::new(text).map(u8::from).collect()
+}
+
+/// Generate morse audio from symbol bytes produced by `morse_symbols`
+#[wasm_bindgen]
+pub fn morse_audio_from_symbols(symbols: &[u8], config_json: &str) -> Result<Vec<f32>, JsValue> {
+    let config: MorseConfig = if config_json.trim().is_empty() {
+        MorseConfig::default()
+    } else {
+        serde_json::from_str(config_json)
+            .map_err(|e| JsValue::from_str(&format!("Invalid config JSON: {}", e)))?
+    };
+
+    let symbols = symbols
+        .iter()
+        .map(|&byte| MorseSymbol::try_from(byte))
+        .collect::<Result<Vec<_>, _>>()
+        .map_err(|e| JsValue::from_str(&e))?;
+    let elements = timing::morse_timing_from_symbols(&symbols, &config.to_timing_params())
+        .map_err(|e| JsValue::from_str(&e))?;
+
+    audio::morse_audio(&elements, &config.to_audio_params()).map_err(|e| JsValue::from_str(&e))
+}
+
+/// Timing of a text box's contents, re-timed incrementally as it is edited
+#[wasm_bindgen]
+pub struct MorseTimingEditor {
+    session: timing::MorseTimingSession,
+}
+
+#[wasm_bindgen]
+impl MorseTimingEditor {
+    #[wasm_bindgen(constructor)]
+    pub fn new(text: &str, config_json: &str) -> Result<MorseTimingEditor, JsValue> {
+        let config: MorseConfig = if config_json.trim().is_empty() {
+            MorseConfig::default()
+        } else {
+            serde_json::from_str(config_json)
+                .map_err(|e| JsValue::from_str(&format!("Invalid config JSON: {}", e)))?
+        };
+
+        let session = timing::MorseTimingSession::new(text, &config.to_timing_params())
+            .map_err(|e| JsValue::from_str(&e))?;
+        Ok(MorseTimingEditor { session })
+    }
+
+    /// Replace the text, returning the changed element range as JSON
+    pub fn set_text(&mut self, text: &str) -> Result<String, JsValue> {
+        let patch = self.session.set_text(text);
+        serde_json::to_string(&patch)
+            .map_err(|e| JsValue::from_str(&format!("JSON serialization error: {}", e)))
+    }
+
+    /// Replace the text between `start` and `end`, in UTF-16 code units as JavaScript counts
+    /// them (e.g. a text box's selection), returning the changed element range as JSON
+    pub fn edit(&mut self, start: usize, end: usize, replacement: &str) -> Result<String, JsValue> {
+        let text = self.session.text();
+        let range = utf16_to_byte_offset(text, start)?..utf16_to_byte_offset(text, end)?;
+        let patch = self
+            .session
+            .edit(range, replacement)
+            .map_err(|e| JsValue::from_str(&e))?;
+        serde_json::to_string(&patch)
+            .map_err(|e| JsValue::from_str(&format!("JSON serialization error: {}", e)))
+    }
+
+    /// Timing elements of the current text as JSON
+    pub fn elements_json(&self) -> Result<String, JsValue> {
+        serde_json::to_string(self.session.elements())
+            .map_err(|e| JsValue::from_str(&format!("JSON serialization error: {}", e)))
+    }
+}
+
+// Byte offset in `text` of a JavaScript string offset
+fn utf16_to_byte_offset(text: &str, offset: usize) -> Result<usize, JsValue> {
+    let mut units = 0;
+    let ends = text.char_indices().chain(std::iter::once((text.len(), '\0')));
+    for (byte, ch) in ends {
+        if units >= offset {
+            if units == offset {
+                return Ok(byte);
+            }
+            break; // Inside a surrogate pair
+        }
+        units += ch.len_utf16();
+    }
+    Err(JsValue::from_str("Invalid edit range"))
+}
+
 /// Interpret morse signals from JSON
 #[wasm_bindgen]
 pub fn morse_interpret_json(signals_json: &str, config_json: &str) -> Result<String, JsValue> {
@@ -1,249 +1,462 @@
+use crate::channel::{Interference, Propagation};
+use crate::filter::FilterCascade;
+use crate::pcm::linear_to_g711;
+use crate::reverb::Reverb;
 use crate::types::{
-    MorseAudioMode, MorseAudioParams, MorseElement, MorseElementType, MorseWaveformType,
+    MorseAudioMode, MorseAudioParams, MorseElement, MorseElementType, MorseG711Law,
+    MorseWaveformType,
 };
+use std::collections::{HashMap, HashSet, VecDeque};
 use std::f32::consts::PI;
+use std::iter::Copied;
+use std::slice::Iter;
 
 // Audio constants
-const ATTACK_MS: f32 = 5.0; // Envelope attack time to prevent audio clicks
+pub(crate) const ATTACK_MS: f32 = 5.0; // Envelope attack time to prevent audio clicks
 const RELEASE_MS: f32 = 5.0; // Envelope release time to prevent audio clicks
 const TELEGRAPH_CLICK_DURATION_SEC: f32 = 0.010; // 10ms click duration
-const SQRT2: f32 = std::f32::consts::SQRT_2;
-
-// Simple PRNG for noise generation
-struct AudioRng {
-    state: u32,
+pub(crate) const STATIC_SEED: u32 = 12345;
+const ROOM_TONE_SEED: u32 = 0x68E3_1DA4;
+const DITHER_SEEDS: [u32; 2] = [0x2545_F491, 0xB529_7A4D]; // Two draws per dithered sample
+const ENCODE_BLOCK: usize = 1024; // Float samples rendered per step of integer output
+const ROOM_TONE_BLOCK: usize = 256; // White noise generated ahead of the room tone lowpass
+const WARM_UP_MIN: usize = 1024; // Also covers the room tone lowpass memory (0.98^1024 < 1e-8)
+const WINDOW_EXACT_REACH: usize = 4; // Longest warm-up, in minimum warm-ups, to start in a gap
+
+// Key-up click: the armature falling back is lower, softer and quieter than the strike. Its
+// level also scales with solenoid_response, how firmly the armature is pulled back.
+const RELEASE_CLICK_FREQ: f32 = 0.8;
+const RELEASE_CLICK_SHARPNESS: f32 = 0.5;
+const RELEASE_CLICK_VOLUME: f32 = 0.4;
+
+// Counter-based white noise: each sample is a hash of its absolute sample index and a seed.
+// Samples do not depend on each other, so blocks of noise vectorise, and the noise at any
+// position of a message is available without generating what comes before it.
+#[derive(Clone, Copy)]
+pub(crate) struct WhiteNoise {
+    seed: u32,
 }
 
-impl AudioRng {
-    fn new() -> Self {
-        Self { state: 12345 }
+impl WhiteNoise {
+    pub(crate) const fn new(seed: u32) -> Self {
+        Self { seed }
     }
 
-    fn next_f32(&mut self) -> f32 {
-        self.state = self.state.wrapping_mul(1103515245).wrapping_add(12345);
-        (self.state >> 16) as f32 / 32768.0 - 1.0 // Range [-1, 1]
+    // Integer finaliser with good avalanche on consecutive inputs (lowbias32)
+    #[inline(always)]
+    fn mix(mut x: u32) -> u32 {
+        x ^= x >> 16;
+        x = x.wrapping_mul(0x7FEB_352D);
+        x ^= x >> 15;
+        x = x.wrapping_mul(0x846C_A68B);
+        x ^ (x >> 16)
     }
-}
 
-// Biquad filter structure
-#[derive(Clone, Default)]
-struct BiquadFilter {
-    a0: f32,
-    a1: f32,
-    a2: f32,
-    b1: f32,
-    b2: f32,
-    x1: f32,
-    x2: f32,
-    y1: f32,
-    y2: f32,
-}
+    // Key for the 2^32 samples sharing the high half of their index
+    fn key(&self, index: u64) -> u32 {
+        Self::mix(self.seed ^ Self::mix((index >> 32) as u32))
+    }
 
-impl BiquadFilter {
-    fn new_lowpass(cutoff_freq: f32, sample_rate: f32) -> Self {
-        let mut filter = Self::default();
+    // Uniform sample in [-1, 1) with 24 bits of resolution
+    #[inline(always)]
+    fn to_f32(bits: u32) -> f32 {
+        (bits >> 8) as i32 as f32 * (2.0 / 16_777_216.0) - 1.0
+    }
 
-        if cutoff_freq >= sample_rate * 0.49 {
-            // Bypass filter if cutoff is too high
-            filter.a0 = 1.0;
-            filter.a1 = 0.0;
-            filter.a2 = 0.0;
-            filter.b1 = 0.0;
-            filter.b2 = 0.0;
-        } else {
-            let w = 2.0 * PI * cutoff_freq / sample_rate;
-            let cos_w = w.cos();
-            let sin_w = w.sin();
-            let alpha = sin_w / SQRT2; // Q = 0.707 for Butterworth
+    // Raw 32 random bits for sample `index`
+    pub(crate) fn bits(&self, index: u64) -> u32 {
+        Self::mix(index as u32 ^ self.key(index))
+    }
+
+    pub(crate) fn sample(&self, index: u64) -> f32 {
+        Self::to_f32(self.bits(index))
+    }
 
-            let norm = 1.0 + alpha;
-            filter.a0 = (1.0 - cos_w) / (2.0 * norm);
-            filter.a1 = (1.0 - cos_w) / norm;
-            filter.a2 = (1.0 - cos_w) / (2.0 * norm);
-            filter.b1 = (-2.0 * cos_w) / norm;
-            filter.b2 = (1.0 - alpha) / norm;
+    // Add `scale` times the noise for samples `start..start + block.len()` into `block`
+    pub(crate) fn add_to(&self, start: u64, scale: f32, block: &mut [f32]) {
+        #[cfg(target_arch = "x86_64")]
+        if is_x86_feature_detected!("avx2") {
+            // SAFETY: AVX2 support was just checked
+            return unsafe { self.add_to_avx2(start, scale, block) };
         }
 
-        filter
+        self.add_to_inline(start, scale, block)
     }
 
-    fn new_highpass(cutoff_freq: f32, sample_rate: f32) -> Self {
-        let mut filter = Self::default();
+    // The hash is integer multiplies, which vectorise far better with AVX2 than with the SSE2
+    // baseline. No floating-point operation changes, so results are identical either way.
+    #[cfg(target_arch = "x86_64")]
+    #[target_feature(enable = "avx2")]
+    unsafe fn add_to_avx2(&self, start: u64, scale: f32, block: &mut [f32]) {
+        self.add_to_inline(start, scale, block)
+    }
 
-        if cutoff_freq <= 1.0 {
-            // Bypass filter if cutoff is too low
-            filter.a0 = 1.0;
-            filter.a1 = 0.0;
-            filter.a2 = 0.0;
-            filter.b1 = 0.0;
-            filter.b2 = 0.0;
-        } else {
-            let w = 2.0 * PI * cutoff_freq / sample_rate;
-            let cos_w = w.cos();
-            let sin_w = w.sin();
-            let alpha = sin_w / SQRT2; // Q = 0.707 for Butterworth
+    #[inline(always)]
+    fn add_to_inline(&self, start: u64, scale: f32, block: &mut [f32]) {
+        let mut start = start;
+        let mut rest = block;
+
+        while !rest.is_empty() {
+            // Split where the high half of the index changes, so the loop is 32-bit only
+            let until_wrap = (1u64 << 32) - (start & 0xFFFF_FFFF);
+            let len = (rest.len() as u64).min(until_wrap) as usize;
+            let (block, tail) = rest.split_at_mut(len);
+            let key = self.key(start);
+            let low = start as u32;
+
+            for (k, out) in block.iter_mut().enumerate() {
+                let bits = Self::mix(low.wrapping_add(k as u32) ^ key);
+                *out += Self::to_f32(bits) * scale;
+            }
 
-            let norm = 1.0 + alpha;
-            filter.a0 = (1.0 + cos_w) / (2.0 * norm);
-            filter.a1 = -(1.0 + cos_w) / norm;
-            filter.a2 = (1.0 + cos_w) / (2.0 * norm);
-            filter.b1 = (-2.0 * cos_w) / norm;
-            filter.b2 = (1.0 - alpha) / norm;
+            start += len as u64;
+            rest = tail;
         }
-
-        filter
     }
+}
 
-    fn process(&mut self, input: f32) -> f32 {
-        let output = self.a0 * input + self.a1 * self.x1 + self.a2 * self.x2
-            - self.b1 * self.y1
-            - self.b2 * self.y2;
-
-        // Update state
-        self.x2 = self.x1;
-        self.x1 = input;
-        self.y2 = self.y1;
-        self.y1 = output;
-
-        output
+// Converts a float sample to 16-bit PCM with one LSB of triangular (TPDF) dither, clipping at
+// full scale. Exact zeros are passed through undithered so digital silence stays silent.
+fn quantize(sample: f32, index: u64) -> i16 {
+    if sample == 0.0 {
+        return 0;
     }
+
+    let [first, second] = DITHER_SEEDS.map(|seed| WhiteNoise::new(seed).sample(index));
+    let dither = (first + second) * 0.5;
+    (sample * 32767.0 + dither)
+        .round()
+        .clamp(i16::MIN as f32, i16::MAX as f32) as i16
 }
 
-// Waveform generation
-fn generate_waveform(waveform_type: MorseWaveformType, frequency: f32, time: f32) -> f32 {
-    let phase = 2.0 * PI * frequency * time;
+// Tone oscillator driven by a phase accumulator. The renderer positions it from the absolute
+// sample clock at key-down, so like a keyed transmitter the carrier keeps running through gaps
+// and every element picks it up where it would be rather than restarting at phase zero.
+#[derive(Clone, Copy, PartialEq)]
+struct Oscillator {
+    waveform_type: MorseWaveformType,
+    phase: f64,     // Position within the current cycle, in [0, 1)
+    increment: f64, // Cycles per sample
+}
 
-    match waveform_type {
-        MorseWaveformType::Sine => phase.sin(),
+impl Oscillator {
+    fn new(waveform_type: MorseWaveformType, frequency: f32, sample_rate: f32) -> Self {
+        Self {
+            waveform_type,
+            phase: 0.0,
+            increment: frequency as f64 / sample_rate as f64,
+        }
+    }
 
-        MorseWaveformType::Square => {
-            if phase.sin() >= 0.0 {
-                1.0
-            } else {
-                -1.0
+    // Write the next `block.len()` waveform samples
+    fn render(&mut self, block: &mut [f32]) {
+        match self.waveform_type {
+            MorseWaveformType::Sine => self.render_sine(block),
+            MorseWaveformType::Square => {
+                self.render_with(block, |p| if p < 0.5 { 1.0 } else { -1.0 })
             }
+            MorseWaveformType::Sawtooth => self.render_with(block, |p| 2.0 * p - 1.0),
+            MorseWaveformType::Triangle => self.render_with(block, |p| {
+                if p <= 0.5 {
+                    4.0 * p - 1.0 // Rising edge: -1 to 1
+                } else {
+                    3.0 - 4.0 * p // Falling edge: 1 to -1
+                }
+            }),
         }
+    }
 
-        MorseWaveformType::Sawtooth => {
-            let normalized_phase = phase % (2.0 * PI);
-            (normalized_phase / PI) - 1.0
+    // Jump to the phase the carrier has `samples` samples after `phase`
+    fn set_phase(&mut self, phase: f64, samples: usize) {
+        self.phase = (phase + samples as f64 * self.increment).fract();
+    }
+
+    // Sine by recursive complex rotation: one sin/cos pair per call, then only multiplies.
+    // Callers keep blocks short (OSCILLATOR_RESYNC) so rotation drift stays negligible.
+    fn render_sine(&mut self, block: &mut [f32]) {
+        let (rot_im, rot_re) = (2.0 * std::f64::consts::PI * self.increment).sin_cos();
+        let (mut im, mut re) = (2.0 * std::f64::consts::PI * self.phase).sin_cos();
+
+        for out in block.iter_mut() {
+            *out = im as f32;
+            let next_re = re * rot_re - im * rot_im;
+            im = re * rot_im + im * rot_re;
+            re = next_re;
         }
 
-        MorseWaveformType::Triangle => {
-            let normalized_phase = phase % (2.0 * PI);
-            if normalized_phase <= PI {
-                (2.0 * normalized_phase / PI) - 1.0 // Rising edge: -1 to 1
-            } else {
-                3.0 - (2.0 * normalized_phase / PI) // Falling edge: 1 to -1
+        self.set_phase(self.phase, block.len());
+    }
+
+    fn render_with(&mut self, block: &mut [f32], shape: impl Fn(f64) -> f64) {
+        for out in block.iter_mut() {
+            *out = shape(self.phase) as f32;
+            self.phase += self.increment;
+            if self.phase >= 1.0 {
+                self.phase -= 1.0;
             }
         }
     }
 }
 
-// Room tone generation (filtered noise)
-struct RoomToneGenerator {
-    prev_sample: f32,
-    rng: AudioRng,
+// Key-down phases are snapped to this many positions per cycle so that elements of equal length
+// share a rendered template. The envelope starts at zero, so the snap is inaudible.
+const PHASE_BUCKETS: u64 = 32;
+const TEMPLATE_CACHE_MAX_SAMPLES: usize = 1 << 20; // Cap on cached template samples (4 MB)
+const TEMPLATE_CACHE_MAX_SEEN: usize = 4096; // Keys remembered from a single use
+const OSCILLATOR_RESYNC: usize = 256; // Oscillator is repositioned every this many samples
+
+// Everything that shapes a rendered tone element besides its length and key-down phase
+#[derive(Clone, Copy, PartialEq)]
+struct ToneShape {
+    oscillator: Oscillator,
+    volume: f32,
+    attack_samples: usize,
+    release_samples: usize,
 }
 
-impl RoomToneGenerator {
-    fn new() -> Self {
+impl ToneShape {
+    fn new(params: &MorseAudioParams) -> Self {
+        let radio = &params.radio_params;
+        let sample_rate = params.sample_rate as f32;
+
         Self {
-            prev_sample: 0.0,
-            rng: AudioRng::new(),
+            oscillator: Oscillator::new(radio.waveform_type, radio.freq_hz, sample_rate),
+            volume: params.volume.clamp(0.0, 1.0),
+            attack_samples: ((ATTACK_MS / 1000.0) * sample_rate) as usize,
+            release_samples: ((RELEASE_MS / 1000.0) * sample_rate) as usize,
         }
     }
 
-    fn generate(&mut self) -> f32 {
-        // White noise base
-        let white = self.rng.next_f32() * 0.6;
+    // Phase bucket of the carrier at an absolute sample index
+    fn phase_bucket(&self, sample_index: u64) -> u16 {
+        let phase = (sample_index as f64 * self.oscillator.increment).fract();
+        ((phase * PHASE_BUCKETS as f64).round() as u64 % PHASE_BUCKETS) as u16
+    }
+
+    // Render samples `offset..offset + block.len()` of a tone element: waveform times
+    // volume times the attack/release envelope. The oscillator is repositioned on a fixed grid
+    // from the element start, so the result does not depend on how the element is split up.
+    fn render(&self, key: TemplateKey, offset: usize, block: &mut [f32]) {
+        let elem_samples = key.samples;
+        let attack_samples = self.attack_samples.min(elem_samples / 2);
+        let release_samples = self.release_samples.min(elem_samples / 2);
+        let release_start = elem_samples.saturating_sub(release_samples);
+
+        let mut oscillator = self.oscillator;
+        let key_down_phase = key.bucket as f64 / PHASE_BUCKETS as f64;
+        let mut scratch = [0.0; OSCILLATOR_RESYNC];
+        let mut done = 0;
+
+        while done < block.len() {
+            let j = offset + done;
+            let grid_start = j - j % OSCILLATOR_RESYNC;
+            let skip = j - grid_start;
+            let count = (OSCILLATOR_RESYNC - skip).min(block.len() - done);
+
+            oscillator.set_phase(key_down_phase, grid_start);
+            oscillator.render(&mut scratch[..skip + count]);
+            block[done..done + count].copy_from_slice(&scratch[skip..skip + count]);
+            done += count;
+        }
 
-        // Add some low-frequency content (simple 1-pole lowpass)
-        let alpha = 0.02; // Very gentle filtering
-        self.prev_sample = self.prev_sample * (1.0 - alpha) + white * alpha;
+        for (j, out) in (offset..).zip(block.iter_mut()) {
+            let mut envelope = 1.0;
 
-        // Mix white noise with filtered version for warmth
-        white * 0.3 + self.prev_sample * 0.7
+            if j < attack_samples {
+                envelope = j as f32 / attack_samples as f32;
+            } else if j >= release_start {
+                envelope = (elem_samples - j) as f32 / release_samples as f32;
+            }
+
+            *out = *out * self.volume * envelope;
+        }
     }
 }
 
-// Radio mode audio generation
-fn morse_audio_radio(
-    events: &[MorseElement],
-    params: &MorseAudioParams,
-) -> Result<Vec<f32>, String> {
-    let radio = &params.radio_params;
-    if radio.freq_hz <= 0.0 || radio.freq_hz > 20000.0 {
-        return Err("Invalid frequency".to_string());
+#[derive(Clone, Copy, PartialEq, Eq, Hash)]
+struct TemplateKey {
+    element_type: MorseElementType,
+    samples: usize,
+    bucket: u16,
+}
+
+/// Cache of pre-rendered tone elements.
+///
+/// Without humanization every dot (and every dash) has the same length, so a radio render only
+/// ever synthesises a handful of distinct elements; the rest is copying. A cache can be moved
+/// between streams to reuse its templates across renders with the same parameters, and is
+/// cleared automatically when used with different ones. A template is only kept once its
+/// length and phase come round a second time, so the one-off lengths of humanized timing are
+/// rendered directly and don't fill the cache.
+#[derive(Default)]
+pub struct ToneTemplateCache {
+    shape: Option<ToneShape>,
+    templates: HashMap<TemplateKey, Vec<f32>>,
+    seen: HashSet<TemplateKey>, // Used once and not yet cached
+    cached_samples: usize,
+}
+
+impl ToneTemplateCache {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    fn prepare(&mut self, shape: ToneShape) {
+        if self.shape != Some(shape) {
+            self.templates.clear();
+            self.seen.clear();
+            self.cached_samples = 0;
+            self.shape = Some(shape);
+        }
     }
 
-    let clamped_volume = params.volume.clamp(0.0, 1.0);
+    // Template for `key`, for a block `position` samples into the element, rendering it when
+    // an element starts with the key for the second time. None when it isn't cached, in which
+    // case the caller renders directly.
+    fn get(&mut self, key: TemplateKey, position: usize) -> Option<&[f32]> {
+        if !self.templates.contains_key(&key) {
+            let shape = self.shape?;
+            if position > 0 || self.cached_samples + key.samples > TEMPLATE_CACHE_MAX_SAMPLES {
+                return None;
+            }
+            if !self.seen.remove(&key) {
+                if self.seen.len() >= TEMPLATE_CACHE_MAX_SEEN {
+                    self.seen.clear();
+                }
+                self.seen.insert(key);
+                return None;
+            }
 
-    // Initialize filters
-    let mut lowpass = BiquadFilter::new_lowpass(params.low_pass_cutoff, params.sample_rate as f32);
-    let mut highpass =
-        BiquadFilter::new_highpass(params.high_pass_cutoff, params.sample_rate as f32);
-    let mut rng = AudioRng::new();
+            let mut template = vec![0.0; key.samples];
+            shape.render(key, 0, &mut template);
+            self.cached_samples += key.samples;
+            self.templates.insert(key, template);
+        }
 
-    let mut samples = Vec::new();
+        self.templates.get(&key).map(Vec::as_slice)
+    }
+}
 
-    for elem in events {
-        let elem_samples = (elem.duration_seconds * params.sample_rate as f32) as usize;
+// Number of samples an element occupies - durations are truncated per element, not in total
+pub(crate) fn element_samples(duration_seconds: f32, sample_rate: f32) -> usize {
+    (duration_seconds * sample_rate) as usize
+}
 
-        if elem.element_type == MorseElementType::Gap {
-            // Generate gap samples (silence with optional static)
-            for _ in 0..elem_samples {
-                let mut signal = 0.0;
+// Room tone generation (filtered noise)
+const ROOM_TONE_ALPHA: f32 = 0.02; // One-pole lowpass coefficient: very gentle filtering
+const ROOM_TONE_GROUP: usize = 8; // Lowpass outputs computed together from the group's start
 
-                // Add background static if enabled
-                if radio.background_static_level > 0.0 {
-                    signal = rng.next_f32() * radio.background_static_level * clamped_volume;
-                }
+struct RoomToneGenerator {
+    lowpass: f32,                      // Lowpass output just before the current group
+    decay: [f32; ROOM_TONE_GROUP + 1], // (1 - alpha)^k
+    response: [[f32; ROOM_TONE_GROUP]; ROOM_TONE_GROUP],
+    noise: WhiteNoise,
+}
 
-                // Apply filters
-                let filtered = highpass.process(signal);
-                let output = lowpass.process(filtered);
-                samples.push(output);
+impl RoomToneGenerator {
+    fn new() -> Self {
+        let mut decay = [1.0; ROOM_TONE_GROUP + 1];
+        for k in 1..decay.len() {
+            decay[k] = decay[k - 1] * (1.0 - ROOM_TONE_ALPHA);
+        }
+
+        // Response of the group's outputs to each of its inputs
+        let mut response = [[0.0; ROOM_TONE_GROUP]; ROOM_TONE_GROUP];
+        for (i, column) in response.iter_mut().enumerate() {
+            for j in i..ROOM_TONE_GROUP {
+                column[j] = decay[j - i] * ROOM_TONE_ALPHA;
             }
-        } else {
-            // Generate tone with envelope
-            let attack_samples = ((ATTACK_MS / 1000.0) * params.sample_rate as f32) as usize;
-            let release_samples = ((RELEASE_MS / 1000.0) * params.sample_rate as f32) as usize;
-
-            // Clamp envelope lengths to element duration
-            let attack_samples = attack_samples.min(elem_samples / 2);
-            let release_samples = release_samples.min(elem_samples / 2);
-            let _sustain_start = attack_samples;
-            let release_start = elem_samples.saturating_sub(release_samples);
-
-            for j in 0..elem_samples {
-                let t = j as f32 / params.sample_rate as f32;
-                let mut envelope = 1.0;
-
-                // Calculate envelope
-                if j < attack_samples {
-                    envelope = j as f32 / attack_samples as f32;
-                } else if j >= release_start {
-                    envelope = (elem_samples - j) as f32 / release_samples as f32;
-                }
+        }
+
+        Self {
+            lowpass: 0.0,
+            decay,
+            response,
+            noise: WhiteNoise::new(ROOM_TONE_SEED),
+        }
+    }
+
+    // Add `scale` times the room tone for samples `start..start + block.len()` into `block`.
+    //
+    // The one-pole lowpass is evaluated a group at a time: a prefix scan over the group's own
+    // input, plus the decayed output from before the group. The scans are independent, leaving
+    // one multiply-add per group serial. Groups sit on a fixed grid of absolute sample indices
+    // and the noise can be regenerated for any index, so the result does not depend on how the
+    // stream is split up.
+    fn add_to(&mut self, start: u64, scale: f32, block: &mut [f32]) {
+        #[cfg(target_arch = "x86_64")]
+        if is_x86_feature_detected!("avx2") {
+            // SAFETY: AVX2 support was just checked
+            return unsafe { self.add_to_avx2(start, scale, block) };
+        }
 
-                let waveform = generate_waveform(radio.waveform_type, radio.freq_hz, t);
-                let mut signal = waveform * clamped_volume * envelope;
+        self.add_to_inline(start, scale, block)
+    }
+
+    #[cfg(target_arch = "x86_64")]
+    #[target_feature(enable = "avx2")]
+    unsafe fn add_to_avx2(&mut self, start: u64, scale: f32, block: &mut [f32]) {
+        self.add_to_inline(start, scale, block)
+    }
 
-                // Add background static if enabled
-                if radio.background_static_level > 0.0 {
-                    signal += rng.next_f32() * radio.background_static_level * clamped_volume;
+    #[inline(always)]
+    fn add_to_inline(&mut self, start: u64, scale: f32, block: &mut [f32]) {
+        let mut index = start;
+
+        for out in block.chunks_mut(ROOM_TONE_BLOCK) {
+            let group_start = index - index % ROOM_TONE_GROUP as u64;
+            let skip = (index - group_start) as usize;
+            let len = (skip + out.len()).div_ceil(ROOM_TONE_GROUP) * ROOM_TONE_GROUP;
+
+            // White noise base for every group touched
+            let mut white = [0.0; ROOM_TONE_BLOCK + ROOM_TONE_GROUP];
+            let white = &mut white[..len];
+            self.noise.add_to_inline(group_start, 0.6, white);
+
+            // Add some low-frequency content: y[j] = (1 - alpha) y[j - 1] + alpha white[j].
+            // Within a group that is the group's input through a triangular matrix, independent
+            // of other groups, plus the decayed output from before the group.
+            let mut lowpass = [0.0; ROOM_TONE_BLOCK + ROOM_TONE_GROUP];
+            let lowpass = &mut lowpass[..len];
+            for (y, w) in lowpass
+                .chunks_exact_mut(ROOM_TONE_GROUP)
+                .zip(white.chunks_exact(ROOM_TONE_GROUP))
+            {
+                let mut sum = [0.0; ROOM_TONE_GROUP];
+                for (column, &w) in self.response.iter().zip(w) {
+                    for (sum, &weight) in sum.iter_mut().zip(column) {
+                        *sum += weight * w;
+                    }
                 }
+                y.copy_from_slice(&sum);
+            }
+
+            let (mut state, mut before) = (self.lowpass, self.lowpass);
+            for y in lowpass.chunks_exact_mut(ROOM_TONE_GROUP) {
+                before = state;
+                for (y, &decay) in y.iter_mut().zip(&self.decay[1..]) {
+                    *y += decay * before;
+                }
+                state = y[ROOM_TONE_GROUP - 1];
+            }
 
-                // Apply filters
-                let filtered = highpass.process(signal);
-                let output = lowpass.process(filtered);
-                samples.push(output);
+            // The state stays at the start of a group the block only partly covers
+            let complete = (skip + out.len()).is_multiple_of(ROOM_TONE_GROUP);
+            self.lowpass = if complete { state } else { before };
+
+            // Mix white noise with filtered version for warmth
+            let range = skip..skip + out.len();
+            for ((out, &w), &y) in out
+                .iter_mut()
+                .zip(&white[range.clone()])
+                .zip(&lowpass[range])
+            {
+                *out += (w * 0.3 + y * 0.7) * scale;
             }
+
+            index += out.len() as u64;
         }
     }
-
-    Ok(samples)
 }
 
 // Telegraph click generation with mechanical resonance
@@ -284,68 +497,534 @@ fn generate_telegraph_click(
     signal * decay * attack * volume_multiplier
 }
 
-// Telegraph mode audio generation (simplified version)
-fn morse_audio_telegraph(
-    events: &[MorseElement],
-    params: &MorseAudioParams,
-) -> Result<Vec<f32>, String> {
-    let telegraph = &params.telegraph_params;
-    let clamped_volume = params.volume.clamp(0.0, 1.0);
+// Telegraph clicks, rendered once per stream and mixed into the output by overlap-add at each
+// key-down and key-up, so the per-sample click synthesis cost is paid per parameter set rather
+// than per element
+struct ClickKernels {
+    key_down: Vec<f32>,
+    key_up: Vec<f32>,
+}
+
+impl ClickKernels {
+    fn new(params: &MorseAudioParams) -> Self {
+        if params.audio_mode != MorseAudioMode::Telegraph {
+            return Self {
+                key_down: Vec::new(),
+                key_up: Vec::new(),
+            };
+        }
+
+        let telegraph = &params.telegraph_params;
+        let sample_rate = params.sample_rate as f32;
+        let volume = params.volume.clamp(0.0, 1.0);
+        let samples = element_samples(TELEGRAPH_CLICK_DURATION_SEC, sample_rate);
+        let render = |freq: f32, sharpness: f32, level: f32| {
+            (0..samples)
+                .map(|j| {
+                    let t = j as f32 / sample_rate;
+                    generate_telegraph_click(t, telegraph, freq, sharpness, level)
+                })
+                .collect()
+        };
+
+        Self {
+            key_down: render(1.0, 1.0, volume),
+            key_up: render(
+                RELEASE_CLICK_FREQ,
+                RELEASE_CLICK_SHARPNESS,
+                volume * RELEASE_CLICK_VOLUME * telegraph.solenoid_response.clamp(0.0, 1.0),
+            ),
+        }
+    }
+
+    fn kernel(&self, click: Click) -> &[f32] {
+        if click.key_up {
+            &self.key_up
+        } else {
+            &self.key_down
+        }
+    }
 
-    // Initialize filters
-    let mut lowpass = BiquadFilter::new_lowpass(params.low_pass_cutoff, params.sample_rate as f32);
-    let mut highpass =
-        BiquadFilter::new_highpass(params.high_pass_cutoff, params.sample_rate as f32);
-    let mut room_tone = RoomToneGenerator::new();
+    // Absolute sample just past the end of `click`
+    fn end(&self, click: Click) -> u64 {
+        click.start + self.kernel(click).len() as u64
+    }
+}
 
-    let mut samples = Vec::new();
+// A click placed at an absolute sample index
+#[derive(Clone, Copy)]
+struct Click {
+    start: u64,
+    key_up: bool,
+}
 
-    for elem in events {
-        let elem_samples = (elem.duration_seconds * params.sample_rate as f32) as usize;
+/// A run of audio from `MorseAudioStream::next_segment`
+#[derive(Debug, PartialEq)]
+pub enum MorseAudioSegment<'a> {
+    /// This many samples of exact silence
+    Silence(usize),
+    /// Rendered samples
+    Samples(&'a [f32]),
+}
 
-        if elem.element_type == MorseElementType::Gap {
-            // Generate gap samples with optional room tone
-            for _ in 0..elem_samples {
-                let mut signal = 0.0;
+/// Streaming renderer that yields morse audio in caller-sized blocks.
+///
+/// Holds the filter, noise and element state of a render so that long messages can be played
+/// or written out with memory proportional to the block size rather than the message length.
+/// The concatenation of all blocks is bit-identical to `morse_audio`, whatever block sizes are
+/// used.
+pub struct MorseAudioStream<I> {
+    elements: I,
+    params: MorseAudioParams,
+    volume: f32,
+    filters: FilterCascade,
+    tone: ToneShape,
+    templates: ToneTemplateCache,
+    static_noise: WhiteNoise,
+    propagation: Option<Propagation>,
+    interference: Option<Interference>,
+    room_tone: RoomToneGenerator,
+    click_kernels: ClickKernels,
+    clicks: VecDeque<Click>, // Placed clicks that have not finished, in order of start
+    reverb: Option<Reverb>,
+    element_type: MorseElementType,
+    elem_samples: usize,
+    position: usize,
+    key_down_bucket: u16,
+    sample_index: u64,
+    finished: bool,
+}
+
+impl<'a> MorseAudioStream<Copied<Iter<'a, MorseElement>>> {
+    /// Create a stream over a slice of timing elements
+    pub fn new(events: &'a [MorseElement], params: &MorseAudioParams) -> Result<Self, String> {
+        Self::from_elements(events.iter().copied(), params)
+    }
+}
+
+impl<I: Iterator<Item = MorseElement>> MorseAudioStream<I> {
+    /// Create a stream over any source of timing elements
+    pub fn from_elements<J>(elements: J, params: &MorseAudioParams) -> Result<Self, String>
+    where
+        J: IntoIterator<IntoIter = I>,
+    {
+        if params.sample_rate <= 0 || params.sample_rate > 192000 {
+            return Err("Invalid sample rate".to_string());
+        }
+
+        if params.audio_mode == MorseAudioMode::Radio {
+            let freq_hz = params.radio_params.freq_hz;
+            if freq_hz <= 0.0 || freq_hz > 20000.0 {
+                return Err("Invalid frequency".to_string());
+            }
+        }
 
-                // Add room tone if enabled
-                if telegraph.room_tone_level > 0.0 {
-                    signal = room_tone.generate() * telegraph.room_tone_level * clamped_volume;
+        let sample_rate = params.sample_rate as f32;
+        let volume = params.volume.clamp(0.0, 1.0);
+
+        let (propagation, interference) = match params.audio_mode {
+            MorseAudioMode::Radio => {
+                let channel = &params.radio_params.channel;
+                let freq_hz = params.radio_params.freq_hz;
+                (
+                    Propagation::new(channel, freq_hz, sample_rate),
+                    Interference::new(channel, freq_hz, volume, sample_rate)?,
+                )
+            }
+            MorseAudioMode::Telegraph => (None, None),
+        };
+
+        Ok(Self {
+            elements: elements.into_iter(),
+            params: params.clone(),
+            volume,
+            filters: FilterCascade::new(
+                params.high_pass_cutoff,
+                params.low_pass_cutoff,
+                sample_rate,
+            ),
+            tone: ToneShape::new(params),
+            templates: ToneTemplateCache::new(),
+            static_noise: WhiteNoise::new(STATIC_SEED),
+            propagation,
+            interference,
+            room_tone: RoomToneGenerator::new(),
+            click_kernels: ClickKernels::new(params),
+            clicks: VecDeque::new(),
+            reverb: match params.audio_mode {
+                MorseAudioMode::Telegraph => {
+                    Reverb::new(params.telegraph_params.reverb_amount, sample_rate)
                 }
+                MorseAudioMode::Radio => None,
+            },
+            element_type: MorseElementType::Gap,
+            elem_samples: 0,
+            position: 0,
+            key_down_bucket: 0,
+            sample_index: 0,
+            finished: false,
+        })
+    }
+
+    /// Use `cache` for tone templates, keeping whatever it already holds if it was last used
+    /// with the same tone parameters
+    pub fn with_template_cache(mut self, cache: ToneTemplateCache) -> Self {
+        self.templates = cache;
+        self
+    }
+
+    /// Take back the template cache so it can be reused by a later render
+    pub fn into_template_cache(self) -> ToneTemplateCache {
+        self.templates
+    }
 
-                // Apply filters
-                let filtered = highpass.process(signal);
-                let output = lowpass.process(filtered);
-                samples.push(output);
+    // Start the stream at absolute sample `sample_index` of a longer message, so that noise and
+    // carrier phase continue where a stream over the whole message would have them. Filter and
+    // room tone memory start empty, which is why callers warm the stream up first.
+    fn starting_at(mut self, sample_index: u64) -> Self {
+        self.sample_index = sample_index;
+        self.filters.align(sample_index);
+        self
+    }
+
+    // Render and drop the next `samples` samples, returning how many there were
+    fn discard(&mut self, samples: usize) -> usize {
+        let mut scratch = [0.0; ENCODE_BLOCK];
+        let mut skipped = 0;
+        while skipped < samples {
+            let count = (samples - skipped).min(scratch.len());
+            let rendered = self.fill(&mut scratch[..count]);
+            skipped += rendered;
+            if rendered < count {
+                break;
             }
-        } else {
-            // Generate telegraph click
-            let click_samples = (TELEGRAPH_CLICK_DURATION_SEC * params.sample_rate as f32) as usize;
-            let click_samples = click_samples.min(elem_samples);
+        }
+        skipped
+    }
+
+    /// Fill `out` with the next block of samples.
+    /// Returns the number of samples written, which is less than `out.len()` only once the
+    /// stream has reached the end of the message.
+    pub fn fill(&mut self, out: &mut [f32]) -> usize {
+        self.render(out, false)
+    }
+
+    /// Fill `out` with the next block of samples as 16-bit PCM, dithered and clipped.
+    /// Returns the number of samples written, as for `fill`.
+    pub fn fill_pcm16(&mut self, out: &mut [i16]) -> usize {
+        self.fill_encoded(out, |sample| sample)
+    }
+
+    /// Fill `out` with the next block of samples as 8-bit G.711 µ-law or A-law.
+    /// Returns the number of samples written, as for `fill`.
+    pub fn fill_g711(&mut self, out: &mut [u8], law: MorseG711Law) -> usize {
+        self.fill_encoded(out, |sample| linear_to_g711(sample, law))
+    }
+
+    // Render through a small float block and encode from it while it is still in cache, so
+    // integer output never needs a full-length float buffer or a second pass
+    fn fill_encoded<T>(&mut self, out: &mut [T], encode: impl Fn(i16) -> T) -> usize {
+        let mut block = [0.0; ENCODE_BLOCK];
+        let mut written = 0;
+
+        while written < out.len() {
+            let count = ENCODE_BLOCK.min(out.len() - written);
+            let start = self.sample_index;
+            let rendered = self.fill(&mut block[..count]);
+
+            for (k, (out, &sample)) in out[written..written + rendered]
+                .iter_mut()
+                .zip(&block)
+                .enumerate()
+            {
+                *out = encode(quantize(sample, start + k as u64));
+            }
+
+            written += rendered;
+            if rendered < count {
+                break;
+            }
+        }
+
+        written
+    }
+
+    /// Render the next segment of the message in sparse form.
+    ///
+    /// Stretches of exact silence (gaps without static or room tone, once the filter ringing has
+    /// decayed) come back as `Silence` runs without any per-sample work; everything else is
+    /// rendered into `buffer`, which must not be empty. Returns None at the end of the message.
+    /// Expanding the runs back to zeros gives exactly the output of `fill`.
+    pub fn next_segment<'b>(&mut self, buffer: &'b mut [f32]) -> Option<MorseAudioSegment<'b>> {
+        debug_assert!(!buffer.is_empty());
+
+        let silence = self.skip_silence();
+        if silence > 0 {
+            return Some(MorseAudioSegment::Silence(silence));
+        }
+
+        let written = self.render(buffer, true);
+        (written > 0).then(|| MorseAudioSegment::Samples(&buffer[..written]))
+    }
+
+    /// Whether every element has been rendered
+    pub fn is_finished(&self) -> bool {
+        self.finished
+    }
+
+    // Shared body of `fill` and `next_segment`. With `stop_at_silence` rendering ends where an
+    // exactly silent stretch begins, so that it can be returned as a run instead.
+    fn render(&mut self, out: &mut [f32], stop_at_silence: bool) -> usize {
+        let mut written = 0;
+
+        while written < out.len() {
+            if self.position >= self.elem_samples && !self.next_element() {
+                break;
+            }
+
+            let mut count = (self.segment_end() - self.position).min(out.len() - written);
+            let block = &mut out[written..written + count];
+
+            let mut reached_silence = false;
+            if self.is_silent() {
+                let ringing = self.filters.ring_out(block);
+                if stop_at_silence {
+                    reached_silence = ringing < count;
+                    count = ringing;
+                } else if ringing < count {
+                    block[ringing..].fill(0.0);
+                    self.filters.skip_silence(count - ringing);
+                }
+            } else {
+                match self.params.audio_mode {
+                    MorseAudioMode::Radio => self.render_radio(block),
+                    MorseAudioMode::Telegraph => self.render_telegraph(block),
+                }
+            }
+
+            self.advance(count);
+            written += count;
+
+            if reached_silence {
+                break;
+            }
+        }
+
+        written
+    }
 
-            for j in 0..elem_samples {
-                let t = j as f32 / params.sample_rate as f32;
-                let mut signal = 0.0;
+    // Consume any exactly silent stretch at the current position, returning its length
+    fn skip_silence(&mut self) -> usize {
+        let mut skipped = 0;
 
-                // Generate click at the beginning
-                if j < click_samples {
-                    signal = generate_telegraph_click(t, telegraph, 1.0, 1.0, clamped_volume);
+        loop {
+            if self.position >= self.elem_samples && !self.next_element() {
+                break;
+            }
+            if !self.is_silent() || !self.filters.is_settled() {
+                break;
+            }
+
+            let count = self.segment_end() - self.position;
+            self.filters.skip_silence(count);
+            self.advance(count);
+            skipped += count;
+        }
+
+        skipped
+    }
+
+    fn advance(&mut self, samples: usize) {
+        self.position += samples;
+        self.sample_index += samples as u64;
+    }
+
+    // End of the stretch of the current element that renders the same way. Telegraph segments
+    // also end where a click starts or finishes and where the reverb tail is snapped to silence,
+    // and radio segments where the multipath echo dies, so the silence fast path starts at the
+    // same sample however the stream is divided into blocks.
+    fn segment_end(&self) -> usize {
+        let now = self.sample_index;
+        let boundary = self
+            .clicks
+            .iter()
+            .map(|&click| {
+                if click.start > now {
+                    click.start
+                } else {
+                    self.click_kernels.end(click)
                 }
+            })
+            .chain(self.reverb.as_ref().map(Reverb::ring_until))
+            .chain(self.propagation.as_ref().map(Propagation::ring_until))
+            .filter(|&boundary| boundary > now)
+            .min();
+
+        match boundary {
+            Some(boundary) => {
+                (self.position as u64 + boundary - now).min(self.elem_samples as u64) as usize
+            }
+            None => self.elem_samples,
+        }
+    }
 
-                // Add room tone if enabled
-                if telegraph.room_tone_level > 0.0 {
-                    signal += room_tone.generate() * telegraph.room_tone_level * clamped_volume;
+    // Whether the current segment has no input signal at all
+    fn is_silent(&self) -> bool {
+        match self.params.audio_mode {
+            MorseAudioMode::Radio => {
+                self.element_type == MorseElementType::Gap
+                    && self.params.radio_params.background_static_level <= 0.0
+                    && self.interference.is_none()
+                    && self
+                        .propagation
+                        .as_ref()
+                        .is_none_or(|propagation| propagation.ring_until() <= self.sample_index)
+            }
+            MorseAudioMode::Telegraph => {
+                let now = self.sample_index;
+                self.params.telegraph_params.room_tone_level <= 0.0
+                    && self
+                        .reverb
+                        .as_ref()
+                        .is_none_or(|reverb| reverb.ring_until() <= now)
+                    && !self
+                        .clicks
+                        .iter()
+                        .any(|&click| click.start <= now && self.click_kernels.end(click) > now)
+            }
+        }
+    }
+
+    fn next_element(&mut self) -> bool {
+        match self.elements.next() {
+            Some(elem) => {
+                self.element_type = elem.element_type;
+                self.elem_samples =
+                    element_samples(elem.duration_seconds, self.params.sample_rate as f32);
+                self.position = 0;
+                self.place_clicks();
+                if let Some(propagation) = &mut self.propagation {
+                    if self.element_type != MorseElementType::Gap {
+                        propagation.excite(self.sample_index + self.elem_samples as u64);
+                    }
                 }
+                true
+            }
+            None => {
+                self.finished = true;
+                false
+            }
+        }
+    }
 
-                // Apply filters
-                let filtered = highpass.process(signal);
-                let output = lowpass.process(filtered);
-                samples.push(output);
+    // Telegraph mode: drop finished clicks and place the key-down and key-up clicks of a new
+    // element
+    fn place_clicks(&mut self) {
+        if self.params.audio_mode != MorseAudioMode::Telegraph {
+            return;
+        }
+
+        while let Some(&click) = self.clicks.front() {
+            if self.click_kernels.end(click) > self.sample_index {
+                break;
+            }
+            self.clicks.pop_front();
+        }
+
+        if self.element_type != MorseElementType::Gap {
+            let key_down = self.sample_index;
+            let key_up = key_down + self.elem_samples as u64;
+            let key_up_click = Click {
+                start: key_up,
+                key_up: true,
+            };
+            self.clicks.push_back(Click {
+                start: key_down,
+                key_up: false,
+            });
+            self.clicks.push_back(key_up_click);
+
+            if let Some(reverb) = &mut self.reverb {
+                reverb.excite(self.click_kernels.end(key_up_click));
             }
         }
     }
 
-    Ok(samples)
+    // Radio mode: keyed tone with attack/release envelope through the HF channel, with optional
+    // static
+    fn render_radio(&mut self, block: &mut [f32]) {
+        let static_level = self.params.radio_params.background_static_level;
+
+        if self.element_type == MorseElementType::Gap {
+            block.fill(0.0);
+        } else {
+            if self.position == 0 {
+                self.key_down_bucket = self.tone.phase_bucket(self.sample_index);
+            }
+
+            let key = TemplateKey {
+                element_type: self.element_type,
+                samples: self.elem_samples,
+                bucket: self.key_down_bucket,
+            };
+
+            self.templates.prepare(self.tone);
+            match self.templates.get(key, self.position) {
+                Some(template) => {
+                    block.copy_from_slice(&template[self.position..self.position + block.len()])
+                }
+                None => self.tone.render(key, self.position, block),
+            }
+        }
+
+        if let Some(propagation) = &mut self.propagation {
+            propagation.process(block, self.sample_index);
+        }
+        if let Some(interference) = &self.interference {
+            interference.add_to(block, self.sample_index);
+        }
+
+        if static_level > 0.0 {
+            self.static_noise
+                .add_to(self.sample_index, static_level * self.volume, block);
+        }
+
+        self.filters.process(block);
+    }
+
+    // Telegraph mode: the clicks overlapping the block through the room reverb, over optional
+    // room tone
+    fn render_telegraph(&mut self, block: &mut [f32]) {
+        let room_tone_level = self.params.telegraph_params.room_tone_level;
+
+        block.fill(0.0);
+        let block_start = self.sample_index;
+        let block_end = block_start + block.len() as u64;
+        for &click in &self.clicks {
+            let kernel = self.click_kernels.kernel(click);
+            let from = click.start.max(block_start);
+            let to = self.click_kernels.end(click).min(block_end);
+            if from >= to {
+                continue;
+            }
+
+            let target = &mut block[(from - block_start) as usize..(to - block_start) as usize];
+            let source = &kernel[(from - click.start) as usize..(to - click.start) as usize];
+            for (out, &sample) in target.iter_mut().zip(source) {
+                *out += sample;
+            }
+        }
+
+        if let Some(reverb) = &mut self.reverb {
+            reverb.process(block, block_start);
+        }
+        if room_tone_level > 0.0 {
+            self.room_tone
+                .add_to(block_start, room_tone_level * self.volume, block);
+        }
+
+        self.filters.process(block);
+    }
 }
 
 /// Generate morse code audio from timing elements
@@ -354,17 +1033,105 @@ pub fn morse_audio(events: &[MorseElement], params: &MorseAudioParams) -> Result
         return Ok(Vec::new());
     }
 
-    if params.sample_rate <= 0 || params.sample_rate > 192000 {
-        return Err("Invalid sample rate".to_string());
+    let mut samples = vec![0.0; morse_audio_size(events, params)?];
+    morse_audio_into(events, params, &mut samples)?;
+    Ok(samples)
+}
+
+/// Render morse code audio into a caller-provided buffer without allocating.
+/// The buffer must hold at least `morse_audio_size` samples; returns the number written.
+pub fn morse_audio_into(
+    events: &[MorseElement],
+    params: &MorseAudioParams,
+    out: &mut [f32],
+) -> Result<usize, String> {
+    if events.is_empty() {
+        return Ok(0);
+    }
+
+    let total_samples = output_size(events, params, out.len())?;
+
+    let mut stream = MorseAudioStream::new(events, params)?;
+    Ok(stream.fill(&mut out[..total_samples]))
+}
+
+/// Generate morse code audio as 16-bit PCM, dithered and clipped
+pub fn morse_audio_pcm16(
+    events: &[MorseElement],
+    params: &MorseAudioParams,
+) -> Result<Vec<i16>, String> {
+    if events.is_empty() {
+        return Ok(Vec::new());
+    }
+
+    let mut samples = vec![0; morse_audio_size(events, params)?];
+    morse_audio_pcm16_into(events, params, &mut samples)?;
+    Ok(samples)
+}
+
+/// Render morse code audio as 16-bit PCM into a caller-provided buffer of at least
+/// `morse_audio_size` samples; returns the number written
+pub fn morse_audio_pcm16_into(
+    events: &[MorseElement],
+    params: &MorseAudioParams,
+    out: &mut [i16],
+) -> Result<usize, String> {
+    if events.is_empty() {
+        return Ok(0);
+    }
+
+    let total_samples = output_size(events, params, out.len())?;
+    let mut stream = MorseAudioStream::new(events, params)?;
+    Ok(stream.fill_pcm16(&mut out[..total_samples]))
+}
+
+/// Generate morse code audio as 8-bit G.711 µ-law or A-law
+pub fn morse_audio_g711(
+    events: &[MorseElement],
+    params: &MorseAudioParams,
+    law: MorseG711Law,
+) -> Result<Vec<u8>, String> {
+    if events.is_empty() {
+        return Ok(Vec::new());
+    }
+
+    let mut samples = vec![0; morse_audio_size(events, params)?];
+    morse_audio_g711_into(events, params, law, &mut samples)?;
+    Ok(samples)
+}
+
+/// Render morse code audio as 8-bit G.711 into a caller-provided buffer of at least
+/// `morse_audio_size` samples; returns the number written
+pub fn morse_audio_g711_into(
+    events: &[MorseElement],
+    params: &MorseAudioParams,
+    law: MorseG711Law,
+    out: &mut [u8],
+) -> Result<usize, String> {
+    if events.is_empty() {
+        return Ok(0);
     }
 
-    match params.audio_mode {
-        MorseAudioMode::Radio => morse_audio_radio(events, params),
-        MorseAudioMode::Telegraph => morse_audio_telegraph(events, params),
+    let total_samples = output_size(events, params, out.len())?;
+    let mut stream = MorseAudioStream::new(events, params)?;
+    Ok(stream.fill_g711(&mut out[..total_samples], law))
+}
+
+// Size of the render, checked against the capacity of the caller's buffer
+fn output_size(
+    events: &[MorseElement],
+    params: &MorseAudioParams,
+    capacity: usize,
+) -> Result<usize, String> {
+    let total_samples = morse_audio_size(events, params)?;
+    if capacity < total_samples {
+        return Err("Output buffer too small".to_string());
     }
+    Ok(total_samples)
 }
 
-/// Calculate the total number of samples needed for the given timing elements
+/// Calculate the total number of samples needed for the given timing elements.
+/// Matches the per-element truncation applied by the renderers, so the result is exact.
 pub fn morse_audio_size(
     events: &[MorseElement],
     params: &MorseAudioParams,
@@ -373,7 +1140,741 @@ pub fn morse_audio_size(
         return Err("Invalid sample rate".to_string());
     }
 
-    let total_duration: f32 = events.iter().map(|e| e.duration_seconds).sum();
+    let sample_rate = params.sample_rate as f32;
+
+    Ok(events
+        .iter()
+        .map(|e| element_samples(e.duration_seconds, sample_rate))
+        .sum())
+}
+
+// Samples a stream started at an element boundary needs before its output matches a stream
+// over the whole message: the filter ringing, room tone lowpass, key-up click and reverb tail, or
+// multipath echo, left by elements before the boundary
+fn warm_up_samples(params: &MorseAudioParams) -> usize {
+    let sample_rate = params.sample_rate as f32;
+    let filters = FilterCascade::new(params.high_pass_cutoff, params.low_pass_cutoff, sample_rate);
+    let tail = match params.audio_mode {
+        MorseAudioMode::Telegraph if params.telegraph_params.reverb_amount > 0.0 => {
+            Reverb::settle_samples(sample_rate)
+        }
+        MorseAudioMode::Telegraph => 0,
+        MorseAudioMode::Radio => Propagation::new(
+            &params.radio_params.channel,
+            params.radio_params.freq_hz,
+            sample_rate,
+        )
+        .map_or(0, |propagation| propagation.span()),
+    };
+
+    filters.settle_samples().max(WARM_UP_MIN)
+        + element_samples(TELEGRAPH_CLICK_DURATION_SEC, sample_rate)
+        + tail
+}
+
+/// Largest difference between a sample from `morse_audio_window` and the same sample from
+/// `morse_audio`
+pub const WINDOW_TOLERANCE: f32 = 1e-3; // -60 dB
+
+/// Render the samples of a message from sample `start` on, as many as fit in `out`, at a cost
+/// proportional to the window rather than to `start`. Returns the number written, which is less
+/// than `out.len()` only where the message ends.
+///
+/// Element offsets are summed up to the window, and a stream starts at an element boundary
+/// early enough for the filter, reverb and channel state to build back up. Where a gap long
+/// enough for the ringing to decay lies shortly before `start`, the stream starts there instead;
+/// without noise that state had snapped to silence and the window is identical to the same
+/// stretch of `morse_audio`. Otherwise samples agree to within WINDOW_TOLERANCE.
+pub fn morse_audio_window_into(
+    events: &[MorseElement],
+    params: &MorseAudioParams,
+    start: usize,
+    out: &mut [f32],
+) -> Result<usize, String> {
+    if params.sample_rate <= 0 {
+        return Err("Invalid sample rate".to_string());
+    }
+
+    let sample_rate = params.sample_rate as f32;
+    let warm_up = warm_up_samples(params);
+
+    // The latest element boundary a full warm-up before `start`, and the latest long gap
+    // starting that early
+    let (mut from, mut from_offset) = (0, 0);
+    let mut settled = None;
+    let mut offset = 0;
+    for (index, event) in events.iter().enumerate() {
+        if offset + warm_up > start {
+            break;
+        }
+        (from, from_offset) = (index, offset);
+
+        let samples = element_samples(event.duration_seconds, sample_rate);
+        if event.element_type == MorseElementType::Gap && samples >= warm_up {
+            settled = Some((index, offset));
+        }
+        offset += samples;
+    }
+    if let Some((index, offset)) = settled {
+        if start - offset <= WINDOW_EXACT_REACH * warm_up {
+            (from, from_offset) = (index, offset);
+        }
+    }
+
+    let mut stream =
+        MorseAudioStream::new(&events[from..], params)?.starting_at(from_offset as u64);
+    if stream.discard(start - from_offset) < start - from_offset {
+        return Ok(0);
+    }
+    Ok(stream.fill(out))
+}
+
+/// Render `len` samples of a message from sample `start` on, or fewer where the message ends.
+/// See `morse_audio_window_into`.
+pub fn morse_audio_window(
+    events: &[MorseElement],
+    params: &MorseAudioParams,
+    start: usize,
+    len: usize,
+) -> Result<Vec<f32>, String> {
+    let available = morse_audio_size(events, params)?.saturating_sub(start);
+    let mut samples = vec![0.0; len.min(available)];
+    morse_audio_window_into(events, params, start, &mut samples)?;
+    Ok(samples)
+}
+
+/// Largest difference between a sample from `morse_audio_parallel` and from `morse_audio`
+#[cfg(feature = "parallel")]
+pub const PARALLEL_TOLERANCE: f32 = 1e-3; // -60 dB
+
+#[cfg(feature = "parallel")]
+const PARALLEL_CHUNKS_PER_THREAD: usize = 4;
+
+/// Generate morse code audio using all available cores
+#[cfg(feature = "parallel")]
+pub fn morse_audio_parallel(
+    events: &[MorseElement],
+    params: &MorseAudioParams,
+) -> Result<Vec<f32>, String> {
+    if events.is_empty() {
+        return Ok(Vec::new());
+    }
+
+    let mut samples = vec![0.0; morse_audio_size(events, params)?];
+    morse_audio_parallel_into(events, params, &mut samples)?;
+    Ok(samples)
+}
+
+/// Render morse code audio into a caller-provided buffer using all available cores.
+///
+/// The message is cut partway into gaps long enough for the filter ringing to decay, and each
+/// chunk is rendered by its own stream from the start of the gap before it, so the chunks can be
+/// rendered independently. A chunk starts with empty filter memory rather than the decayed
+/// ringing of the serial render. Without noise that ringing has snapped to silence by the cut
+/// and the output is identical to `morse_audio_into`; with static or room tone, float rounding
+/// in the filter differs slightly and samples agree to within PARALLEL_TOLERANCE. Short
+/// messages, or ones without long gaps, render serially. A gap must also outlast the reverb
+/// tail, about 0.8 s, so telegraph audio with reverb on only parallelises at slow speeds or
+/// with long pauses; at 20 WPM a word gap is 0.42 s and the message renders serially.
+#[cfg(feature = "parallel")]
+pub fn morse_audio_parallel_into(
+    events: &[MorseElement],
+    params: &MorseAudioParams,
+    out: &mut [f32],
+) -> Result<usize, String> {
+    if events.is_empty() {
+        return Ok(0);
+    }
+
+    let total_samples = output_size(events, params, out.len())?;
+
+    let out = &mut out[..total_samples];
+    let threads = crate::parallel::thread_count();
+    if threads == 1 {
+        return Ok(MorseAudioStream::new(events, params)?.fill(out));
+    }
+
+    render_chunks(events, params, out, threads * PARALLEL_CHUNKS_PER_THREAD)?;
+    Ok(total_samples)
+}
+
+// Render `out`, which holds the whole message, as up to `chunks` independent pieces, returning
+// how many it used
+#[cfg(feature = "parallel")]
+fn render_chunks(
+    events: &[MorseElement],
+    params: &MorseAudioParams,
+    out: &mut [f32],
+    chunks: usize,
+) -> Result<usize, String> {
+    let sample_rate = params.sample_rate as f32;
+    let min_gap = warm_up_samples(params);
+    let total_samples = out.len();
+    let target = (total_samples / chunks).max(params.sample_rate as usize);
+
+    // Cut points: (element index of the gap, its first sample, the sample to cut at)
+    let mut cuts = vec![(0, 0, 0)];
+    let mut offset = 0;
+    for (index, event) in events.iter().enumerate() {
+        let samples = element_samples(event.duration_seconds, sample_rate);
+        let cut = offset + min_gap;
+        if event.element_type == MorseElementType::Gap
+            && samples > min_gap
+            && cut - cuts[cuts.len() - 1].2 >= target
+            && total_samples - cut >= target
+        {
+            cuts.push((index, offset, cut));
+        }
+        offset += samples;
+    }
+
+    let pieces = cuts.len();
+    let mut tasks = Vec::with_capacity(pieces);
+    let mut rest = out;
+    for (i, &(index, start, cut)) in cuts.iter().enumerate() {
+        let end = cuts.get(i + 1).map_or(total_samples, |next| next.2);
+        let (chunk, tail) = rest.split_at_mut(end - cut);
+        rest = tail;
+
+        let stream = MorseAudioStream::new(&events[index..], params)?.starting_at(start as u64);
+        tasks.push((stream, cut - start, chunk));
+    }
+
+    crate::parallel::run_parallel(tasks, |(mut stream, warm_up, chunk)| {
+        stream.discard(warm_up);
+        stream.fill(chunk);
+    });
+
+    Ok(pieces)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::timing::morse_timing;
+    use crate::types::{MorseChannelParams, MorseTimingParams};
+
+    fn stream_in_blocks(
+        events: &[MorseElement],
+        params: &MorseAudioParams,
+        block: usize,
+    ) -> Vec<f32> {
+        let mut stream = MorseAudioStream::new(events, params).unwrap();
+        let mut samples = Vec::new();
+        let mut buffer = vec![0.0; block];
+
+        loop {
+            let written = stream.fill(&mut buffer);
+            samples.extend_from_slice(&buffer[..written]);
+            if written < block {
+                break;
+            }
+        }
+
+        samples
+    }
+
+    #[test]
+    fn test_stream_matches_batch() {
+        let events = morse_timing("CQ DE [SK] 73", &MorseTimingParams::default()).unwrap();
+
+        let mut radio = MorseAudioParams::default();
+        radio.radio_params.background_static_level = 0.1;
+        let mut telegraph = MorseAudioParams {
+            audio_mode: MorseAudioMode::Telegraph,
+            ..Default::default()
+        };
+        telegraph.telegraph_params.room_tone_level = 0.2;
+        let mut faded = MorseAudioParams::default();
+        faded.radio_params.channel = MorseChannelParams {
+            fading_spread_hz: 1.0,
+            qsb_depth: 0.5,
+            ..Default::default()
+        };
+        let mut interfered = faded.clone();
+        interfered.radio_params.channel.qrn_level = 0.3;
+        interfered.radio_params.channel.qrm_level = 0.2;
+
+        for params in [radio, telegraph, faded, interfered] {
+            let batch = morse_audio(&events, &params).unwrap();
+            for block in [1, 7, 256, 100_000] {
+                assert_eq!(stream_in_blocks(&events, &params, block), batch);
+            }
+        }
+    }
+
+    #[test]
+    fn test_window_matches_full_render() {
+        let timing = MorseTimingParams {
+            word_gap_multiplier: 3.0,
+            ..Default::default()
+        };
+        let events = morse_timing("PARIS PARIS PARIS PARIS", &timing).unwrap();
+        let mut radio = MorseAudioParams::default();
+        radio.radio_params.background_static_level = 0.0;
+        let mut telegraph = MorseAudioParams {
+            audio_mode: MorseAudioMode::Telegraph,
+            ..Default::default()
+        };
+        telegraph.telegraph_params.room_tone_level = 0.0;
+        let mut noisy = MorseAudioParams::default();
+        noisy.radio_params.background_static_level = 0.2;
+
+        for (params, exact) in [(radio, true), (telegraph, true), (noisy, false)] {
+            let full = morse_audio(&events, &params).unwrap();
+
+            for start in [0, 1, 5000, full.len() / 3, full.len() - 700, full.len() + 5] {
+                let window = morse_audio_window(&events, &params, start, 4000).unwrap();
+                let expected = &full[start.min(full.len())..(start + 4000).min(full.len())];
+                assert_eq!(window.len(), expected.len());
+
+                // The final word gap is long enough to settle, so only noise can differ
+                let worst = window
+                    .iter()
+                    .zip(expected)
+                    .fold(0.0f32, |m, (a, b)| m.max((a - b).abs()));
+                if exact && start > full.len() / 2 {
+                    assert_eq!(window, expected);
+                }
+                assert!(worst <= WINDOW_TOLERANCE, "{start}: {worst}");
+            }
+        }
+    }
+
+    #[test]
+    fn test_audio_into_reuses_buffer() {
+        let params = MorseAudioParams::default();
+        let timing = MorseTimingParams {
+            humanization_factor: 0.5,
+            random_seed: 42,
+            ..Default::default()
+        };
+        let mut buffer = Vec::new();
+
+        for text in ["PARIS", "HELLO WORLD", "E"] {
+            let events = morse_timing(text, &timing).unwrap();
+            let size = morse_audio_size(&events, &params).unwrap();
+            buffer.resize(buffer.len().max(size), 0.0);
+
+            let written = morse_audio_into(&events, &params, &mut buffer).unwrap();
+            assert_eq!(written, size);
+            assert_eq!(&buffer[..written], morse_audio(&events, &params).unwrap());
+            assert!(morse_audio_into(&events, &params, &mut buffer[..size - 1]).is_err());
+        }
+    }
+
+    #[test]
+    fn test_oscillator_is_phase_continuous() {
+        let (freq, sample_rate) = (700.0, 44100.0);
+        let waveforms = [
+            MorseWaveformType::Sine,
+            MorseWaveformType::Square,
+            MorseWaveformType::Sawtooth,
+            MorseWaveformType::Triangle,
+        ];
+
+        for waveform_type in waveforms {
+            // Render in uneven pieces with skipped gaps, then compare to the ideal waveform
+            let mut oscillator = Oscillator::new(waveform_type, freq, sample_rate);
+            let mut n = 0usize;
+            for (len, skip) in [(1000, 0), (3, 517), (20_000, 4410), (777, 1)] {
+                let mut block = vec![0.0; len];
+                oscillator.set_phase(0.0, n);
+                oscillator.render(&mut block);
+
+                for (i, &sample) in block.iter().enumerate() {
+                    let phase = ((n + i) as f64 * freq as f64 / sample_rate as f64).fract();
+                    let expected = match waveform_type {
+                        MorseWaveformType::Sine => (2.0 * std::f64::consts::PI * phase).sin(),
+                        MorseWaveformType::Square => 1.0f64.copysign(0.5 - phase),
+                        MorseWaveformType::Sawtooth => 2.0 * phase - 1.0,
+                        MorseWaveformType::Triangle => 1.0 - 4.0 * (phase - 0.5).abs(),
+                    };
+                    // Square edges may land a sample either side of the ideal crossing
+                    let near_edge = phase < 1e-6 || (phase - 0.5).abs() < 1e-6;
+                    if !near_edge {
+                        assert!(
+                            (sample as f64 - expected).abs() < 1e-4,
+                            "{:?}",
+                            waveform_type
+                        );
+                    }
+                }
+
+                n += len + skip;
+            }
+        }
+    }
+
+    #[test]
+    fn test_template_cache_matches_direct_render() {
+        let events = morse_timing("PARIS PARIS", &MorseTimingParams::default()).unwrap();
+        let params = MorseAudioParams::default();
+
+        let mut stream = MorseAudioStream::new(&events, &params).unwrap();
+        let first = {
+            let mut samples = vec![0.0; morse_audio_size(&events, &params).unwrap()];
+            stream.fill(&mut samples);
+            samples
+        };
+        let mut cache = stream.into_template_cache();
+
+        // Plain timing only ever needs a dot and a dash per phase bucket
+        assert!(cache.templates.len() <= 2 * PHASE_BUCKETS as usize);
+
+        // Templates are exactly what rendering the element piecewise produces
+        let shape = ToneShape::new(&params);
+        for (&key, template) in &cache.templates {
+            let mut direct = vec![0.0; key.samples];
+            let (head, tail) = direct.split_at_mut(key.samples / 3);
+            shape.render(key, 0, head);
+            shape.render(key, key.samples / 3, tail);
+            assert_eq!(&direct, template);
+        }
+
+        // A warm cache reproduces the same audio; a cache from other params is discarded
+        let mut reused = MorseAudioStream::new(&events, &params)
+            .unwrap()
+            .with_template_cache(cache);
+        let mut second = vec![0.0; first.len()];
+        reused.fill(&mut second);
+        assert_eq!(first, second);
+
+        cache = reused.into_template_cache();
+        let mut other = params.clone();
+        other.radio_params.freq_hz = 600.0;
+        let mut stream = MorseAudioStream::new(&events, &other)
+            .unwrap()
+            .with_template_cache(cache);
+        stream.fill(&mut second);
+        assert_eq!(second, morse_audio(&events, &other).unwrap());
+
+        // Humanized lengths are only cached once they repeat
+        let timing = MorseTimingParams {
+            humanization_factor: 0.5,
+            random_seed: 9,
+            ..Default::default()
+        };
+        let events = morse_timing(&"PARIS ".repeat(20), &timing).unwrap();
+        let mut stream = MorseAudioStream::new(&events, &params).unwrap();
+        let mut samples = vec![0.0; morse_audio_size(&events, &params).unwrap()];
+        stream.fill(&mut samples);
+        assert_eq!(samples, morse_audio(&events, &params).unwrap());
+
+        let sample_rate = params.sample_rate as f32;
+        let mut uses = HashMap::new();
+        for event in events
+            .iter()
+            .filter(|e| e.element_type != MorseElementType::Gap)
+        {
+            *uses
+                .entry(element_samples(event.duration_seconds, sample_rate))
+                .or_insert(0) += 1;
+        }
+        let cache = stream.into_template_cache();
+        assert!(cache.templates.keys().all(|key| uses[&key.samples] >= 2));
+        assert!(cache.templates.len() < uses.len());
+    }
+
+    #[test]
+    fn test_segments_expand_to_dense_output() {
+        let events = morse_timing("CQ CQ DE W1AW  K", &MorseTimingParams::default()).unwrap();
+        let radio = MorseAudioParams::default();
+        let mut telegraph = MorseAudioParams {
+            audio_mode: MorseAudioMode::Telegraph,
+            ..Default::default()
+        };
+        telegraph.telegraph_params.room_tone_level = 0.0;
+        let reverberant = telegraph.clone();
+        telegraph.telegraph_params.reverb_amount = 0.0;
+
+        for (params, gaps_settle) in [(radio, true), (telegraph, true), (reverberant, false)] {
+            let dense = morse_audio(&events, &params).unwrap();
+            for block in [5, 4096] {
+                let mut stream = MorseAudioStream::new(&events, &params).unwrap();
+                let mut buffer = vec![0.0; block];
+                let mut expanded = Vec::new();
+                let mut silent = 0;
+
+                while let Some(segment) = stream.next_segment(&mut buffer) {
+                    match segment {
+                        MorseAudioSegment::Silence(n) => {
+                            expanded.resize(expanded.len() + n, 0.0);
+                            silent += n;
+                        }
+                        MorseAudioSegment::Samples(samples) => expanded.extend_from_slice(samples),
+                    }
+                }
+
+                assert_eq!(expanded, dense);
+                // Word gaps are long enough for the filters to settle, but not the reverb
+                assert_eq!(silent > dense.len() / 10, gaps_settle);
+            }
+        }
+    }
+
+    #[test]
+    fn test_telegraph_clicks_at_key_down_and_key_up() {
+        let events = morse_timing("EE TM", &MorseTimingParams::default()).unwrap();
+        let mut params = MorseAudioParams {
+            audio_mode: MorseAudioMode::Telegraph,
+            high_pass_cutoff: 0.0,
+            low_pass_cutoff: 48000.0,
+            ..Default::default()
+        };
+        params.telegraph_params.room_tone_level = 0.0;
+        params.telegraph_params.reverb_amount = 0.0;
+        let rendered = morse_audio(&events, &params).unwrap();
+
+        // Reference: every click computed sample by sample at its absolute position
+        let sample_rate = params.sample_rate as f32;
+        let telegraph = &params.telegraph_params;
+        let click_samples = element_samples(TELEGRAPH_CLICK_DURATION_SEC, sample_rate);
+        let mut expected = vec![0.0; rendered.len()];
+        let mut onset = 0;
+        for event in &events {
+            let samples = element_samples(event.duration_seconds, sample_rate);
+            if event.element_type != MorseElementType::Gap {
+                for (start, freq, sharpness, level) in [
+                    (onset, 1.0, 1.0, 1.0),
+                    (
+                        onset + samples,
+                        RELEASE_CLICK_FREQ,
+                        RELEASE_CLICK_SHARPNESS,
+                        RELEASE_CLICK_VOLUME * telegraph.solenoid_response,
+                    ),
+                ] {
+                    for j in 0..click_samples.min(expected.len().saturating_sub(start)) {
+                        let t = j as f32 / sample_rate;
+                        expected[start + j] +=
+                            generate_telegraph_click(t, telegraph, freq, sharpness, 0.5 * level);
+                    }
+                }
+            }
+            onset += samples;
+        }
+
+        assert_eq!(rendered, expected);
+    }
+
+    #[test]
+    fn test_integer_output_tracks_float_render() {
+        let events = morse_timing("PARIS", &MorseTimingParams::default()).unwrap();
+        let params = MorseAudioParams {
+            volume: 1.0,
+            ..Default::default()
+        };
+        let float = morse_audio(&events, &params).unwrap();
+        let pcm = morse_audio_pcm16(&events, &params).unwrap();
+        assert_eq!(pcm.len(), float.len());
+
+        for (&f, &p) in float.iter().zip(&pcm) {
+            let expected = (f * 32767.0).clamp(-32768.0, 32767.0);
+            assert!((p as f32 - expected).abs() <= 1.5, "{f} -> {p}");
+            if f == 0.0 {
+                assert_eq!(p, 0);
+            }
+        }
+
+        // Companded output encodes the same dithered samples, whatever the block size
+        for law in [MorseG711Law::Mulaw, MorseG711Law::Alaw] {
+            let g711 = morse_audio_g711(&events, &params, law).unwrap();
+            let expected: Vec<u8> = pcm.iter().map(|&p| linear_to_g711(p, law)).collect();
+            assert_eq!(g711, expected);
+
+            let mut stream = MorseAudioStream::new(&events, &params).unwrap();
+            let mut blocks = Vec::new();
+            let mut buffer = [0; 700];
+            loop {
+                let written = stream.fill_g711(&mut buffer, law);
+                blocks.extend_from_slice(&buffer[..written]);
+                if written < buffer.len() {
+                    break;
+                }
+            }
+            assert_eq!(blocks, g711);
+        }
+
+        let mut short = vec![0; pcm.len() - 1];
+        assert!(morse_audio_pcm16_into(&events, &params, &mut short).is_err());
+    }
+
+    #[test]
+    fn test_white_noise_is_uniform_and_uncorrelated() {
+        let noise = WhiteNoise::new(STATIC_SEED);
+        let samples: Vec<f32> = (0..1 << 16).map(|i| noise.sample(i)).collect();
+        let n = samples.len() as f32;
+
+        let mean = samples.iter().sum::<f32>() / n;
+        let variance = samples.iter().map(|s| s * s).sum::<f32>() / n;
+        assert!(mean.abs() < 0.01);
+        assert!((variance - 1.0 / 3.0).abs() < 0.01);
+        assert!(samples.iter().all(|s| (-1.0..1.0).contains(s)));
+
+        for lag in [1, 2, 8, 256] {
+            let correlation = samples
+                .iter()
+                .zip(&samples[lag..])
+                .map(|(a, b)| a * b)
+                .sum::<f32>()
+                / (n * variance);
+            assert!(correlation.abs() < 0.02, "lag {lag}: {correlation}");
+        }
+
+        // Different seeds give unrelated streams, and the noise is a function of position only
+        let other = WhiteNoise::new(ROOM_TONE_SEED);
+        assert_ne!(noise.sample(1000), other.sample(1000));
+        let mut block = [0.0; 8];
+        noise.add_to(1 << 40, 1.0, &mut block);
+        assert_eq!(block[3], noise.sample((1 << 40) + 3));
+    }
+
+    // Room tone from `start` in blocks of the given sizes, cycled
+    fn room_tone_in_blocks(start: u64, len: usize, sizes: &[usize]) -> Vec<f32> {
+        let mut generator = RoomToneGenerator::new();
+        let mut out = vec![0.0; len];
+        let (mut rest, mut index) = (&mut out[..], start);
+        for &size in sizes.iter().cycle() {
+            if rest.is_empty() {
+                break;
+            }
+            let (block, tail) = rest.split_at_mut(size.min(rest.len()));
+            generator.add_to(index, 1.0, block);
+            index += block.len() as u64;
+            rest = tail;
+        }
+        out
+    }
 
-    Ok((total_duration * params.sample_rate as f32) as usize)
+    #[test]
+    fn test_room_tone_matches_serial_lowpass() {
+        let noise = WhiteNoise::new(ROOM_TONE_SEED);
+        let len = 3000;
+
+        for start in [0, 13, (1 << 32) - 21] {
+            // The lowpass runs from the group grid point at or before the start
+            let grid = start - start % ROOM_TONE_GROUP as u64;
+            let mut y = 0.0;
+            let serial: Vec<f32> = (grid..start + len as u64)
+                .map(|index| {
+                    let w = noise.sample(index) * 0.6;
+                    y = (1.0 - ROOM_TONE_ALPHA) * y + ROOM_TONE_ALPHA * w;
+                    w * 0.3 + y * 0.7
+                })
+                .skip((start - grid) as usize)
+                .collect();
+
+            let whole = room_tone_in_blocks(start, len, &[len]);
+            for (grouped, serial) in whole.iter().zip(&serial) {
+                assert!((grouped - serial).abs() < 1e-6, "{grouped} vs {serial}");
+            }
+
+            // Odd splits, so blocks start off the group grid and straddle noise blocks
+            for sizes in [&[1][..], &[3, 7], &[5, 259, 13], &[255, 1, 257]] {
+                assert_eq!(room_tone_in_blocks(start, len, sizes), whole, "{sizes:?}");
+            }
+        }
+    }
+
+    #[cfg(target_arch = "x86_64")]
+    #[test]
+    fn test_avx2_paths_match_inline() {
+        if !is_x86_feature_detected!("avx2") {
+            return;
+        }
+
+        let noise = WhiteNoise::new(STATIC_SEED);
+        for start in [0, 5, (1 << 32) - 3] {
+            let mut inline = [0.25; 300];
+            let mut avx2 = inline;
+            noise.add_to_inline(start, 0.7, &mut inline);
+            // SAFETY: AVX2 support was just checked
+            unsafe { noise.add_to_avx2(start, 0.7, &mut avx2) };
+            assert_eq!(inline, avx2);
+            for (k, &sample) in inline.iter().enumerate() {
+                assert_eq!(sample, 0.25 + noise.sample(start + k as u64) * 0.7);
+            }
+
+            let (mut inline_tone, mut avx2_tone) =
+                (RoomToneGenerator::new(), RoomToneGenerator::new());
+            let mut index = start;
+            for size in [1, 300, 7, 512, 3] {
+                let mut inline = vec![0.0; size];
+                let mut avx2 = vec![0.0; size];
+                inline_tone.add_to_inline(index, 0.5, &mut inline);
+                // SAFETY: AVX2 support was just checked
+                unsafe { avx2_tone.add_to_avx2(index, 0.5, &mut avx2) };
+                assert_eq!(inline, avx2);
+                index += size as u64;
+            }
+        }
+    }
+
+    #[cfg(feature = "parallel")]
+    #[test]
+    fn test_parallel_matches_serial() {
+        let text = "CQ CQ DE W1AW W1AW K ".repeat(8);
+        let events = morse_timing(&text, &MorseTimingParams::default()).unwrap();
+
+        let clean = MorseAudioParams::default();
+        let mut noisy = MorseAudioParams::default();
+        noisy.radio_params.background_static_level = 0.1;
+        let mut telegraph = MorseAudioParams {
+            audio_mode: MorseAudioMode::Telegraph,
+            ..Default::default()
+        };
+        telegraph.telegraph_params.room_tone_level = 0.2;
+        telegraph.telegraph_params.reverb_amount = 0.0;
+        let mut faded = MorseAudioParams::default();
+        faded.radio_params.channel.fading_spread_hz = 1.0;
+        faded.radio_params.channel.multipath_delay_ms = 2.0;
+
+        for (params, exact) in [
+            (clean, true),
+            (noisy, false),
+            (telegraph, false),
+            (faded, true),
+        ] {
+            let serial = morse_audio(&events, &params).unwrap();
+            assert_eq!(
+                morse_audio_parallel(&events, &params).unwrap().len(),
+                serial.len()
+            );
+
+            let mut chunked = vec![0.0; serial.len()];
+            let pieces = render_chunks(&events, &params, &mut chunked, 8).unwrap();
+            assert!(pieces > 1, "{:?} rendered serially", params.audio_mode);
+
+            if exact {
+                assert_eq!(chunked, serial);
+            }
+            let max_error = serial
+                .iter()
+                .zip(&chunked)
+                .map(|(a, b)| (a - b).abs())
+                .fold(0.0, f32::max);
+            assert!(max_error <= PARALLEL_TOLERANCE, "error {max_error}");
+        }
+
+        // Word gaps at 20 WPM are shorter than the reverb tail, so reverberant telegraph audio
+        // renders as one piece
+        let reverberant = MorseAudioParams {
+            audio_mode: MorseAudioMode::Telegraph,
+            ..Default::default()
+        };
+        let serial = morse_audio(&events, &reverberant).unwrap();
+        let mut chunked = vec![0.0; serial.len()];
+        let pieces = render_chunks(&events, &reverberant, &mut chunked, 8).unwrap();
+        assert_eq!(pieces, 1);
+        assert_eq!(chunked, serial);
+    }
+
+    #[test]
+    fn test_stream_rejects_invalid_params() {
+        let events = morse_timing("E", &MorseTimingParams::default()).unwrap();
+        let mut params = MorseAudioParams::default();
+        params.radio_params.freq_hz = 0.0;
+
+        assert!(MorseAudioStream::new(&events, &params).is_err());
+    }
 }
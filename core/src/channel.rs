@@ -0,0 +1,454 @@
+// HF channel impairments for radio mode: Watterson multipath fading and QSB on the wanted
+// signal, QRN crashes and QRM from a neighbouring station added to it. Every random quantity
+// is counter-based noise keyed by absolute sample (or slot) index and the channel seed, so the
+// result is deterministic, independent of block sizes, and available at any position.
+use crate::audio::{WhiteNoise, ATTACK_MS};
+use crate::types::MorseChannelParams;
+use std::f64::consts::PI;
+
+const FADING_SEEDS: [u32; 4] = [0x9E37_79B9, 0x7F4A_7C15, 0xF39C_C060, 0x5CED_C834];
+const QSB_SEED: u32 = 0xC2B2_AE35;
+const QRN_SEEDS: [u32; 2] = [0x27D4_EB2F, 0x1656_67B1];
+const QRM_SEED: u32 = 0xD3A2_646C;
+
+const MAX_MULTIPATH_MS: f32 = 10.0;
+const CONTROL_RATE: f32 = 16.0; // Smooth noise control points per second, per Hz of bandwidth
+const SMOOTH_HALF_TAPS: usize = 11; // Gaussian filter taps either side, at control rate
+const CHANNEL_BLOCK: usize = 256; // Samples faded per step, after the delay history
+const QRN_SLOT_MS: f32 = 20.0; // At most one crash starts in each slot
+const QRN_DECAY_MS: f32 = 3.0; // Time constant of a crash
+const QRN_LENGTH: f32 = 8.0; // Crash length in time constants (-70 dB)
+const QRM_SYMBOL_UNITS: u64 = 4; // QRM is keyed as dits, dahs or spaces of four dot units
+
+// Gaussian noise with a Gaussian spectrum about `bandwidth_hz` wide: white noise at a control
+// rate well above the bandwidth, smoothed by a Gaussian filter and linearly interpolated
+struct SmoothNoise {
+    noise: WhiteNoise,
+    interval: u64, // Samples between control points
+    taps: [f32; 2 * SMOOTH_HALF_TAPS + 1],
+    cached: (u64, f32, f32), // Last control point used and the values at it and the next
+}
+
+impl SmoothNoise {
+    fn new(seed: u32, bandwidth_hz: f32, sample_rate: f32) -> Self {
+        let interval = ((sample_rate / (CONTROL_RATE * bandwidth_hz)) as u64).max(1);
+
+        // Spectrum with a standard deviation of half the bandwidth (Watterson's 2-sigma
+        // spread), in control samples: sigma_t = rate / (2 * sqrt(2) * pi * sigma_f)
+        let sigma = CONTROL_RATE / (std::f32::consts::SQRT_2 * std::f32::consts::PI);
+        let mut taps = [0.0; 2 * SMOOTH_HALF_TAPS + 1];
+        for (k, tap) in taps.iter_mut().enumerate() {
+            let t = k as f32 - SMOOTH_HALF_TAPS as f32;
+            *tap = (-t * t / (2.0 * sigma * sigma)).exp();
+        }
+        // Unit variance from uniform samples, whose variance is 1/3
+        let norm = (3.0 / taps.iter().map(|t| t * t).sum::<f32>()).sqrt();
+        taps.iter_mut().for_each(|t| *t *= norm);
+
+        let mut smooth = Self {
+            noise: WhiteNoise::new(seed),
+            interval,
+            taps,
+            cached: (0, 0.0, 0.0),
+        };
+        smooth.cached = (0, smooth.control(0), smooth.control(1));
+        smooth
+    }
+
+    fn control(&self, point: u64) -> f32 {
+        // Offset so the filter never reaches below index zero
+        let first = point + (1 << 32) - SMOOTH_HALF_TAPS as u64;
+        self.taps
+            .iter()
+            .enumerate()
+            .map(|(k, &tap)| tap * self.noise.sample(first + k as u64))
+            .sum()
+    }
+
+    // Values at control point `point` and the one after
+    fn around(&mut self, point: u64) -> (f32, f32) {
+        let (cached, _, next) = self.cached;
+        if point != cached {
+            self.cached = if point == cached + 1 {
+                (point, next, self.control(point + 1))
+            } else {
+                (point, self.control(point), self.control(point + 1))
+            };
+        }
+        (self.cached.1, self.cached.2)
+    }
+
+    // The values for samples `start..start + out.len()`
+    fn fill(&mut self, start: u64, out: &mut [f32]) {
+        let mut point = start / self.interval;
+        let mut offset = start % self.interval;
+        let mut done = 0;
+
+        while done < out.len() {
+            let (v0, v1) = self.around(point);
+            let count = ((self.interval - offset) as usize).min(out.len() - done);
+            let step = (v1 - v0) / self.interval as f32;
+            for (k, out) in out[done..done + count].iter_mut().enumerate() {
+                *out = v0 + step * (offset + k as u64) as f32;
+            }
+            done += count;
+            offset = 0;
+            point += 1;
+        }
+    }
+}
+
+// One propagation path: a delay and a complex Rayleigh gain, in-phase and quadrature
+struct Path {
+    delay: usize,
+    in_phase: SmoothNoise,
+    quadrature: SmoothNoise,
+}
+
+/// Multipath fading and QSB applied to the keyed signal.
+///
+/// Each path multiplies the analytic signal by a slowly varying complex gain. The signal is a
+/// keyed carrier, so its Hilbert transform is taken to be the signal a quarter carrier period
+/// earlier; that is exact for a sine carrier and close for its keying sidebands. The result is
+/// `sum over paths of a(t) x(t - d) - b(t) x(t - d - quarter)`, scaled by the QSB gain.
+pub(crate) struct Propagation {
+    paths: Vec<Path>, // Empty: no fading, only QSB
+    scale: f32,       // Unit mean power over the paths
+    quarter_period: usize,
+    qsb: Option<(SmoothNoise, f32)>,
+    span: usize,          // Input samples a fading output sample reaches back over
+    history: Vec<f32>,    // The last `span` input samples, then room for a block
+    gains: [Vec<f32>; 3], // Scratch: in-phase, quadrature and QSB gains for a block
+    ring_until: u64,
+}
+
+impl Propagation {
+    /// None when the channel neither fades nor has QSB
+    pub(crate) fn new(
+        channel: &MorseChannelParams,
+        freq_hz: f32,
+        sample_rate: f32,
+    ) -> Option<Self> {
+        let fading = channel.fading_spread_hz > 0.0;
+        let qsb = channel.qsb_depth > 0.0 && channel.qsb_rate_hz > 0.0;
+        if !fading && !qsb {
+            return None;
+        }
+
+        let mut paths = Vec::new();
+        if fading {
+            let delay_ms = channel.multipath_delay_ms.clamp(0.0, MAX_MULTIPATH_MS);
+            let delay = (delay_ms / 1000.0 * sample_rate) as usize;
+            let delays = if delay > 0 { vec![0, delay] } else { vec![0] };
+
+            for (i, &delay) in delays.iter().enumerate() {
+                let noise = |k: usize| {
+                    SmoothNoise::new(
+                        channel.seed ^ FADING_SEEDS[2 * i + k],
+                        channel.fading_spread_hz,
+                        sample_rate,
+                    )
+                };
+                paths.push(Path {
+                    delay,
+                    in_phase: noise(0),
+                    quadrature: noise(1),
+                });
+            }
+        }
+
+        let quarter_period = ((sample_rate / (4.0 * freq_hz)).round() as usize).max(1);
+        let span = paths
+            .iter()
+            .map(|path| path.delay + quarter_period)
+            .max()
+            .unwrap_or(0);
+
+        Some(Self {
+            scale: (2.0 * paths.len().max(1) as f32).sqrt().recip(),
+            paths,
+            quarter_period,
+            qsb: qsb.then(|| {
+                let noise =
+                    SmoothNoise::new(channel.seed ^ QSB_SEED, channel.qsb_rate_hz, sample_rate);
+                (noise, channel.qsb_depth.min(1.0))
+            }),
+            span,
+            history: vec![0.0; span + CHANNEL_BLOCK],
+            gains: [(); 3].map(|_| vec![0.0; CHANNEL_BLOCK]),
+            ring_until: 0,
+        })
+    }
+
+    /// Samples after the input falls silent until the output is silent too
+    pub(crate) fn span(&self) -> usize {
+        self.span
+    }
+
+    /// Note that input may be non-zero up to absolute sample `until`
+    pub(crate) fn excite(&mut self, until: u64) {
+        self.ring_until = self.ring_until.max(until + self.span as u64);
+    }
+
+    /// Absolute sample from which the output is silent, unless excited again
+    pub(crate) fn ring_until(&self) -> u64 {
+        self.ring_until
+    }
+
+    /// Apply the channel to `block`, which starts at absolute sample `start`, in place
+    pub(crate) fn process(&mut self, block: &mut [f32], start: u64) {
+        if start >= self.ring_until {
+            return;
+        }
+
+        let span = self.span;
+        for (n, chunk) in block.chunks_mut(CHANNEL_BLOCK).enumerate() {
+            let chunk_start = start + (n * CHANNEL_BLOCK) as u64;
+            let len = chunk.len();
+            self.history[span..span + len].copy_from_slice(chunk);
+
+            let [in_phase, quadrature, qsb] = &mut self.gains;
+            if !self.paths.is_empty() {
+                chunk.fill(0.0);
+            }
+            for path in &mut self.paths {
+                path.in_phase.fill(chunk_start, &mut in_phase[..len]);
+                path.quadrature.fill(chunk_start, &mut quadrature[..len]);
+
+                let direct = &self.history[span - path.delay..][..len];
+                let shifted = &self.history[span - path.delay - self.quarter_period..][..len];
+                for ((out, (&a, &b)), (&x, &hx)) in chunk
+                    .iter_mut()
+                    .zip(in_phase.iter().zip(quadrature.iter()))
+                    .zip(direct.iter().zip(shifted))
+                {
+                    *out += (a * x - b * hx) * self.scale;
+                }
+            }
+
+            if let Some((noise, depth)) = &mut self.qsb {
+                noise.fill(chunk_start, &mut qsb[..len]);
+                for (out, &g) in chunk.iter_mut().zip(qsb.iter()) {
+                    // Smooth dips between full strength and 1 - depth
+                    *out *= 1.0 - *depth * (0.5 + 0.5 * (g * std::f32::consts::FRAC_PI_2).sin());
+                }
+            }
+
+            self.history.copy_within(len..len + span, 0);
+        }
+    }
+}
+
+/// QRN crashes and QRM from a neighbouring CW signal, added to the received signal
+pub(crate) struct Interference {
+    crash: WhiteNoise,   // Decides each slot's crash: whether, where and how strong
+    crackle: WhiteNoise, // The noise a crash is made of
+    crash_envelope: Vec<f32>,
+    crash_chance: u32, // Out of 2^32 per slot
+    slot: u64,
+    qrn_level: f32,
+    qrm_keying: WhiteNoise,
+    qrm_level: f32,
+    qrm_cycles: f64, // Carrier cycles per sample
+    qrm_unit: u64,   // Dot length in samples
+    ramp: f32,       // Keying edge length in samples
+}
+
+impl Interference {
+    /// None when the channel has neither QRN nor QRM
+    pub(crate) fn new(
+        channel: &MorseChannelParams,
+        freq_hz: f32,
+        volume: f32,
+        sample_rate: f32,
+    ) -> Result<Option<Self>, String> {
+        let qrn = channel.qrn_level > 0.0 && channel.qrn_rate_hz > 0.0;
+        let qrm = channel.qrm_level > 0.0;
+        if !qrn && !qrm {
+            return Ok(None);
+        }
+
+        let qrm_freq = freq_hz + channel.qrm_offset_hz;
+        if qrm && (qrm_freq <= 0.0 || qrm_freq >= sample_rate / 2.0 || channel.qrm_wpm <= 0.0) {
+            return Err("Invalid QRM parameters".to_string());
+        }
+
+        let slot = ((QRN_SLOT_MS / 1000.0 * sample_rate) as u64).max(1);
+        let decay = QRN_DECAY_MS / 1000.0 * sample_rate;
+        let crash_envelope = (0..(QRN_LENGTH * decay) as usize)
+            .map(|k| (-(k as f32) / decay).exp())
+            .collect();
+        let chance = (channel.qrn_rate_hz * slot as f32 / sample_rate).min(1.0);
+
+        Ok(Some(Self {
+            crash: WhiteNoise::new(channel.seed ^ QRN_SEEDS[0]),
+            crackle: WhiteNoise::new(channel.seed ^ QRN_SEEDS[1]),
+            crash_envelope,
+            crash_chance: if qrn {
+                (chance as f64 * u32::MAX as f64) as u32
+            } else {
+                0
+            },
+            slot,
+            qrn_level: channel.qrn_level * volume,
+            qrm_keying: WhiteNoise::new(channel.seed ^ QRM_SEED),
+            qrm_level: if qrm { channel.qrm_level * volume } else { 0.0 },
+            qrm_cycles: qrm_freq as f64 / sample_rate as f64,
+            qrm_unit: ((1.2 / channel.qrm_wpm.max(1.0) * sample_rate) as u64).max(1),
+            ramp: (ATTACK_MS / 1000.0 * sample_rate).max(1.0),
+        }))
+    }
+
+    /// Add the interference for samples `start..start + block.len()` to `block`
+    pub(crate) fn add_to(&self, block: &mut [f32], start: u64) {
+        if self.crash_chance > 0 {
+            self.add_qrn(block, start);
+        }
+        if self.qrm_level > 0.0 {
+            self.add_qrm(block, start);
+        }
+    }
+
+    fn add_qrn(&self, block: &mut [f32], start: u64) {
+        let end = start + block.len() as u64;
+        let length = self.crash_envelope.len() as u64;
+        let first_slot = start.saturating_sub(length) / self.slot;
+
+        for slot in first_slot..end.div_ceil(self.slot) {
+            let draw = self.crash.bits(3 * slot);
+            if draw >= self.crash_chance {
+                continue;
+            }
+
+            let onset = slot * self.slot + self.crash.bits(3 * slot + 1) as u64 % self.slot;
+            let (from, to) = (onset.max(start), (onset + length).min(end));
+            if from >= to {
+                continue;
+            }
+
+            // Mostly small crashes with the occasional loud one
+            let strength = (self.crash.bits(3 * slot + 2) as f32 / u32::MAX as f32).powi(3);
+            let level = self.qrn_level * (0.1 + 0.9 * strength);
+            let envelope = &self.crash_envelope[(from - onset) as usize..(to - onset) as usize];
+            let target = &mut block[(from - start) as usize..(to - start) as usize];
+            for (k, (out, &env)) in target.iter_mut().zip(envelope).enumerate() {
+                *out += level * env * self.crackle.sample(from + k as u64);
+            }
+        }
+    }
+
+    fn add_qrm(&self, block: &mut [f32], start: u64) {
+        let end = start + block.len() as u64;
+        let symbol = QRM_SYMBOL_UNITS * self.qrm_unit;
+
+        for index in start / symbol..end.div_ceil(symbol) {
+            // Dah, dit or space
+            let units = match self.qrm_keying.bits(index) % 5 {
+                0 | 1 => 3,
+                2 | 3 => 1,
+                _ => continue,
+            };
+            let on = index * symbol;
+            let off = on + units * self.qrm_unit;
+            let (from, to) = (on.max(start), off.min(end));
+            if from >= to {
+                continue;
+            }
+
+            for t in from..to {
+                let edge = ((t - on) as f32 + 0.5).min((off - t) as f32 - 0.5) / self.ramp;
+                let phase = (self.qrm_cycles * t as f64).fract() * 2.0 * PI;
+                block[(t - start) as usize] +=
+                    self.qrm_level * edge.min(1.0) * (phase.sin() as f32);
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn channel() -> MorseChannelParams {
+        MorseChannelParams {
+            fading_spread_hz: 2.0,
+            multipath_delay_ms: 1.0,
+            qsb_depth: 0.5,
+            qsb_rate_hz: 0.5,
+            qrn_level: 0.3,
+            qrn_rate_hz: 20.0,
+            qrm_level: 0.2,
+            seed: 7,
+            ..Default::default()
+        }
+    }
+
+    #[test]
+    fn test_fading_has_unit_mean_power_and_varies() {
+        let sample_rate = 8000.0;
+        let mut propagation = Propagation::new(
+            &MorseChannelParams {
+                fading_spread_hz: 5.0,
+                multipath_delay_ms: 0.5,
+                ..Default::default()
+            },
+            500.0,
+            sample_rate,
+        )
+        .unwrap();
+
+        let len = 400_000;
+        let mut signal: Vec<f32> = (0..len)
+            .map(|t| (2.0 * std::f32::consts::PI * 500.0 * t as f32 / sample_rate).sin())
+            .collect();
+        propagation.excite(len as u64);
+        propagation.process(&mut signal, 0);
+
+        let power = signal.iter().map(|s| (s * s) as f64).sum::<f64>() / len as f64;
+        assert!((power - 0.5).abs() < 0.1, "power {power}");
+
+        // Deep fades and peaks well above the mean
+        let envelope: Vec<f32> = signal
+            .chunks(400)
+            .map(|c| c.iter().fold(0.0f32, |m, s| m.max(s.abs())))
+            .collect();
+        assert!(envelope.iter().any(|&e| e < 0.2));
+        assert!(envelope.iter().any(|&e| e > 1.5));
+    }
+
+    #[test]
+    fn test_channel_independent_of_block_size() {
+        let sample_rate = 8000.0;
+        let input: Vec<f32> = (0..6000)
+            .map(|t| {
+                if t % 1000 < 400 {
+                    ((t * 13) % 17) as f32 / 17.0 - 0.5
+                } else {
+                    0.0
+                }
+            })
+            .collect();
+
+        let render = |block: usize| {
+            let mut propagation = Propagation::new(&channel(), 700.0, sample_rate).unwrap();
+            let interference = Interference::new(&channel(), 700.0, 0.5, sample_rate)
+                .unwrap()
+                .unwrap();
+            propagation.excite(input.len() as u64);
+
+            let mut out = input.clone();
+            for (n, chunk) in out.chunks_mut(block).enumerate() {
+                let start = (n * block) as u64;
+                propagation.process(chunk, start);
+                interference.add_to(chunk, start);
+            }
+            out
+        };
+
+        let whole = render(6000);
+        assert!(whole.iter().any(|&s| s != 0.0));
+        for block in [1, 37, 256, 1000] {
+            assert_eq!(render(block), whole);
+        }
+    }
+}
@@ -0,0 +1,573 @@
+// High-pass/low-pass filter stage shared by the audio renderers
+use std::f32::consts::PI;
+
+const SQRT2: f32 = std::f32::consts::SQRT_2;
+const GROUP: usize = 8; // Samples advanced per state-space step
+const STATES: usize = 4; // Two second-order sections
+const SETTLE_THRESHOLD: f32 = 1e-6; // -120 dB: ringing below this is snapped to exact silence
+
+// Biquad filter structure
+#[derive(Clone, Copy, Default)]
+pub(crate) struct BiquadFilter {
+    a0: f32,
+    a1: f32,
+    a2: f32,
+    b1: f32,
+    b2: f32,
+}
+
+impl BiquadFilter {
+    pub(crate) fn new_lowpass(cutoff_freq: f32, sample_rate: f32) -> Self {
+        let mut filter = Self::default();
+
+        if cutoff_freq >= sample_rate * 0.49 {
+            // Bypass filter if cutoff is too high
+            filter.a0 = 1.0;
+            filter.a1 = 0.0;
+            filter.a2 = 0.0;
+            filter.b1 = 0.0;
+            filter.b2 = 0.0;
+        } else {
+            let w = 2.0 * PI * cutoff_freq / sample_rate;
+            let cos_w = w.cos();
+            let sin_w = w.sin();
+            let alpha = sin_w / SQRT2; // Q = 0.707 for Butterworth
+
+            let norm = 1.0 + alpha;
+            filter.a0 = (1.0 - cos_w) / (2.0 * norm);
+            filter.a1 = (1.0 - cos_w) / norm;
+            filter.a2 = (1.0 - cos_w) / (2.0 * norm);
+            filter.b1 = (-2.0 * cos_w) / norm;
+            filter.b2 = (1.0 - alpha) / norm;
+        }
+
+        filter
+    }
+
+    pub(crate) fn new_highpass(cutoff_freq: f32, sample_rate: f32) -> Self {
+        let mut filter = Self::default();
+
+        if cutoff_freq <= 1.0 {
+            // Bypass filter if cutoff is too low
+            filter.a0 = 1.0;
+            filter.a1 = 0.0;
+            filter.a2 = 0.0;
+            filter.b1 = 0.0;
+            filter.b2 = 0.0;
+        } else {
+            let w = 2.0 * PI * cutoff_freq / sample_rate;
+            let cos_w = w.cos();
+            let sin_w = w.sin();
+            let alpha = sin_w / SQRT2; // Q = 0.707 for Butterworth
+
+            let norm = 1.0 + alpha;
+            filter.a0 = (1.0 + cos_w) / (2.0 * norm);
+            filter.a1 = -(1.0 + cos_w) / norm;
+            filter.a2 = (1.0 + cos_w) / (2.0 * norm);
+            filter.b1 = (-2.0 * cos_w) / norm;
+            filter.b2 = (1.0 - alpha) / norm;
+        }
+
+        filter
+    }
+
+    // Pass-through sections contribute nothing to the cascade
+    fn is_bypass(&self) -> bool {
+        self.a0 == 1.0 && self.a1 == 0.0 && self.a2 == 0.0 && self.b1 == 0.0 && self.b2 == 0.0
+    }
+
+    // Largest pole radius: ringing decays by this factor per sample
+    fn pole_radius(&self) -> f64 {
+        let (b1, b2) = (self.b1 as f64, self.b2 as f64);
+        let disc = b1 * b1 - 4.0 * b2;
+        if disc < 0.0 {
+            b2.sqrt()
+        } else {
+            let root = disc.sqrt();
+            ((-b1 + root) / 2.0).abs().max(((-b1 - root) / 2.0).abs())
+        }
+    }
+
+    // One step of the transposed direct form II realisation, in double precision
+    fn step(&self, state: &mut [f64], input: f64) -> f64 {
+        let output = self.a0 as f64 * input + state[0];
+        state[0] = self.a1 as f64 * input - self.b1 as f64 * output + state[1];
+        state[1] = self.a2 as f64 * input - self.b2 as f64 * output;
+        output
+    }
+}
+
+// Block state-space form of the cascade: for a group of GROUP inputs x and the state s at the
+// start of the group,
+//   y  = D x + C s   (the group's outputs)
+//   s' = B x + A s   (the state at the end of the group)
+// Each output depends only on inputs and the previous group's state, so all of them are
+// computed in parallel lanes; only the small state update is serial from group to group.
+// Matrices are stored by column so each term is a broadcast multiply-add.
+#[derive(Clone)]
+struct BlockMatrices {
+    d: [[f32; GROUP]; GROUP],
+    c: [[f32; GROUP]; STATES],
+    b: [[f32; STATES]; GROUP],
+    a: [[f32; STATES]; STATES],
+}
+
+impl BlockMatrices {
+    // Derive the matrices by running the cascade in double precision from each unit input and
+    // each unit state
+    fn new(sections: &[BiquadFilter; 2]) -> Self {
+        let run = |mut state: [f64; STATES], impulse_at: Option<usize>| {
+            let mut outputs = [0.0; GROUP];
+            for (k, output) in outputs.iter_mut().enumerate() {
+                let input = if impulse_at == Some(k) { 1.0 } else { 0.0 };
+                let (first, second) = state.split_at_mut(2);
+                let y = sections[0].step(first, input);
+                *output = sections[1].step(second, y) as f32;
+            }
+            (outputs, state.map(|v| v as f32))
+        };
+
+        let mut matrices = Self {
+            d: [[0.0; GROUP]; GROUP],
+            c: [[0.0; GROUP]; STATES],
+            b: [[0.0; STATES]; GROUP],
+            a: [[0.0; STATES]; STATES],
+        };
+
+        for j in 0..GROUP {
+            (matrices.d[j], matrices.b[j]) = run([0.0; STATES], Some(j));
+        }
+        for i in 0..STATES {
+            let mut unit = [0.0; STATES];
+            unit[i] = 1.0;
+            (matrices.c[i], matrices.a[i]) = run(unit, None);
+        }
+
+        matrices
+    }
+}
+
+/// High-pass and low-pass sections fused into one fourth-order cascade that filters whole
+/// blocks, GROUP samples per vectorised step.
+///
+/// Output is independent of how the signal is split into blocks: a partial group is computed
+/// with the missing inputs as zero, which the causal D matrix ignores exactly, and the state
+/// only advances once the group is complete.
+#[derive(Clone)]
+pub(crate) struct FilterCascade {
+    matrices: Option<BlockMatrices>,
+    state: [f32; STATES],
+    pending: [f32; GROUP],
+    filled: usize,
+    settle_samples: usize,
+    simd: SimdLevel,
+}
+
+impl FilterCascade {
+    pub(crate) fn new(high_pass_cutoff: f32, low_pass_cutoff: f32, sample_rate: f32) -> Self {
+        let sections = [
+            BiquadFilter::new_highpass(high_pass_cutoff, sample_rate),
+            BiquadFilter::new_lowpass(low_pass_cutoff, sample_rate),
+        ];
+        let bypass = sections.iter().all(BiquadFilter::is_bypass);
+        let radius = sections[0].pole_radius().max(sections[1].pole_radius());
+        let settle_samples = if bypass || radius <= 0.0 {
+            0
+        } else {
+            (f64::from(SETTLE_THRESHOLD).ln() / radius.ln()).ceil() as usize
+        };
+
+        Self {
+            matrices: (!bypass).then(|| BlockMatrices::new(&sections)),
+            state: [0.0; STATES],
+            pending: [0.0; GROUP],
+            filled: 0,
+            settle_samples,
+            simd: SimdLevel::detect(),
+        }
+    }
+
+    /// Filter `block` in place
+    pub(crate) fn process(&mut self, block: &mut [f32]) {
+        let Some(matrices) = &self.matrices else {
+            return;
+        };
+
+        let mut outputs = [0.0; GROUP];
+        let mut next_state = [0.0; STATES];
+        let mut done = 0;
+
+        while done < block.len() {
+            // Whole groups go straight through without staging
+            if self.filled == 0 && block.len() - done >= GROUP {
+                let group: &mut [f32; GROUP] = (&mut block[done..done + GROUP]).try_into().unwrap();
+                let inputs = *group;
+                self.simd
+                    .group(matrices, &self.state, &inputs, group, &mut next_state);
+                self.state = next_state;
+                done += GROUP;
+                continue;
+            }
+
+            let count = (GROUP - self.filled).min(block.len() - done);
+            let range = self.filled..self.filled + count;
+            self.pending[range.clone()].copy_from_slice(&block[done..done + count]);
+
+            self.simd.group(
+                matrices,
+                &self.state,
+                &self.pending,
+                &mut outputs,
+                &mut next_state,
+            );
+            block[done..done + count].copy_from_slice(&outputs[range]);
+
+            self.filled += count;
+            done += count;
+
+            if self.filled == GROUP {
+                self.state = next_state;
+                self.pending = [0.0; GROUP];
+                self.filled = 0;
+            }
+        }
+    }
+
+    /// Whether the cascade holds no signal, so silent input gives exactly silent output
+    pub(crate) fn is_settled(&self) -> bool {
+        self.state == [0.0; STATES] && self.pending == [0.0; GROUP]
+    }
+
+    /// Filter the start of a stretch of silent input until the ringing left by earlier signal
+    /// decays. The state is checked at the end of each group and snapped to zero once it falls
+    /// below SETTLE_THRESHOLD. Returns how many samples of `block` were written; the rest of the
+    /// silence is exactly zero and is handed to `skip_silence`.
+    pub(crate) fn ring_out(&mut self, block: &mut [f32]) -> usize {
+        let mut done = 0;
+
+        while done < block.len() && !self.is_settled() {
+            let count = (GROUP - self.filled).min(block.len() - done);
+            block[done..done + count].fill(0.0);
+            self.process(&mut block[done..done + count]);
+            done += count;
+
+            if self.filled == 0 && self.state.iter().all(|s| s.abs() < SETTLE_THRESHOLD) {
+                self.state = [0.0; STATES];
+            }
+        }
+
+        done
+    }
+
+    /// Samples of silence after which ringing from a full-scale signal has decayed below
+    /// SETTLE_THRESHOLD, estimated from the slowest pole
+    pub(crate) fn settle_samples(&self) -> usize {
+        self.settle_samples
+    }
+
+    /// Line the groups up with a stream that started `sample_index` samples earlier, as if the
+    /// cascade had been fed silence since then. Only valid once settled.
+    pub(crate) fn align(&mut self, sample_index: u64) {
+        debug_assert!(self.is_settled());
+        self.filled = (sample_index % GROUP as u64) as usize;
+    }
+
+    /// Advance over `samples` of silence without computing them. Only valid once settled.
+    pub(crate) fn skip_silence(&mut self, samples: usize) {
+        debug_assert!(self.is_settled());
+        self.filled = (self.filled + samples) % GROUP;
+    }
+}
+
+// Instruction set used for the state-space kernel
+#[derive(Clone, Copy, Debug, PartialEq)]
+enum SimdLevel {
+    #[cfg_attr(
+        any(target_arch = "x86_64", target_feature = "simd128"),
+        allow(dead_code)
+    )]
+    Scalar,
+    #[cfg(target_arch = "x86_64")]
+    Sse,
+    #[cfg(target_arch = "x86_64")]
+    Avx,
+    #[cfg(all(target_arch = "wasm32", target_feature = "simd128"))]
+    Simd128,
+}
+
+impl SimdLevel {
+    #[cfg(target_arch = "x86_64")]
+    fn detect() -> Self {
+        // SSE is part of the x86_64 baseline; AVX needs a runtime check
+        if is_x86_feature_detected!("avx") {
+            SimdLevel::Avx
+        } else {
+            SimdLevel::Sse
+        }
+    }
+
+    #[cfg(all(target_arch = "wasm32", target_feature = "simd128"))]
+    fn detect() -> Self {
+        SimdLevel::Simd128
+    }
+
+    #[cfg(not(any(
+        target_arch = "x86_64",
+        all(target_arch = "wasm32", target_feature = "simd128")
+    )))]
+    fn detect() -> Self {
+        SimdLevel::Scalar
+    }
+
+    // Outputs and end state of one group. Every path accumulates the input terms first and the
+    // state terms last (shortening the serial dependency on the previous group) in the same
+    // order, without fused multiply-adds, so all paths give bit-identical results.
+    fn group(
+        self,
+        m: &BlockMatrices,
+        state: &[f32; STATES],
+        x: &[f32; GROUP],
+        y: &mut [f32; GROUP],
+        next: &mut [f32; STATES],
+    ) {
+        match self {
+            SimdLevel::Scalar => group_scalar(m, state, x, y, next),
+            #[cfg(target_arch = "x86_64")]
+            // SAFETY: SSE is always available on x86_64
+            SimdLevel::Sse => unsafe { x86::group_sse(m, state, x, y, next) },
+            #[cfg(target_arch = "x86_64")]
+            // SAFETY: only selected after runtime detection of AVX
+            SimdLevel::Avx => unsafe { x86::group_avx(m, state, x, y, next) },
+            #[cfg(all(target_arch = "wasm32", target_feature = "simd128"))]
+            SimdLevel::Simd128 => wasm::group_simd128(m, state, x, y, next),
+        }
+    }
+}
+
+fn group_scalar(
+    m: &BlockMatrices,
+    state: &[f32; STATES],
+    x: &[f32; GROUP],
+    y: &mut [f32; GROUP],
+    next: &mut [f32; STATES],
+) {
+    *y = m.d[0].map(|d| x[0] * d);
+    for (term, col) in x.iter().zip(&m.d).skip(1).chain(state.iter().zip(&m.c)) {
+        for (acc, c) in y.iter_mut().zip(col) {
+            *acc += term * c;
+        }
+    }
+
+    *next = m.b[0].map(|b| x[0] * b);
+    for (term, col) in x.iter().zip(&m.b).skip(1).chain(state.iter().zip(&m.a)) {
+        for (acc, c) in next.iter_mut().zip(col) {
+            *acc += term * c;
+        }
+    }
+}
+
+#[cfg(target_arch = "x86_64")]
+#[allow(clippy::needless_range_loop)]
+mod x86 {
+    use super::{BlockMatrices, GROUP, STATES};
+    use std::arch::x86_64::*;
+
+    #[target_feature(enable = "sse")]
+    unsafe fn mul_add4(acc: __m128, term: f32, col: *const f32) -> __m128 {
+        _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(term), _mm_loadu_ps(col)))
+    }
+
+    #[target_feature(enable = "sse")]
+    pub(super) unsafe fn group_sse(
+        m: &BlockMatrices,
+        state: &[f32; STATES],
+        x: &[f32; GROUP],
+        y: &mut [f32; GROUP],
+        next: &mut [f32; STATES],
+    ) {
+        for half in [0, 4] {
+            let mut acc = _mm_mul_ps(_mm_set1_ps(x[0]), _mm_loadu_ps(m.d[0].as_ptr().add(half)));
+            for j in 1..GROUP {
+                acc = mul_add4(acc, x[j], m.d[j].as_ptr().add(half));
+            }
+            for i in 0..STATES {
+                acc = mul_add4(acc, state[i], m.c[i].as_ptr().add(half));
+            }
+            _mm_storeu_ps(y.as_mut_ptr().add(half), acc);
+        }
+
+        _mm_storeu_ps(next.as_mut_ptr(), state_update(m, state, x));
+    }
+
+    #[target_feature(enable = "avx")]
+    pub(super) unsafe fn group_avx(
+        m: &BlockMatrices,
+        state: &[f32; STATES],
+        x: &[f32; GROUP],
+        y: &mut [f32; GROUP],
+        next: &mut [f32; STATES],
+    ) {
+        let mut acc = _mm256_mul_ps(_mm256_set1_ps(x[0]), _mm256_loadu_ps(m.d[0].as_ptr()));
+        for j in 1..GROUP {
+            let product = _mm256_mul_ps(_mm256_set1_ps(x[j]), _mm256_loadu_ps(m.d[j].as_ptr()));
+            acc = _mm256_add_ps(acc, product);
+        }
+        for i in 0..STATES {
+            let product = _mm256_mul_ps(_mm256_set1_ps(state[i]), _mm256_loadu_ps(m.c[i].as_ptr()));
+            acc = _mm256_add_ps(acc, product);
+        }
+        _mm256_storeu_ps(y.as_mut_ptr(), acc);
+
+        _mm_storeu_ps(next.as_mut_ptr(), state_update(m, state, x));
+    }
+
+    #[target_feature(enable = "sse")]
+    unsafe fn state_update(m: &BlockMatrices, state: &[f32; STATES], x: &[f32; GROUP]) -> __m128 {
+        let mut acc = _mm_mul_ps(_mm_set1_ps(x[0]), _mm_loadu_ps(m.b[0].as_ptr()));
+        for j in 1..GROUP {
+            acc = mul_add4(acc, x[j], m.b[j].as_ptr());
+        }
+        for i in 0..STATES {
+            acc = mul_add4(acc, state[i], m.a[i].as_ptr());
+        }
+        acc
+    }
+}
+
+#[cfg(all(target_arch = "wasm32", target_feature = "simd128"))]
+#[allow(clippy::needless_range_loop)]
+mod wasm {
+    use super::{BlockMatrices, GROUP, STATES};
+    use std::arch::wasm32::*;
+
+    // SAFETY (all loads and stores): every pointer addresses four in-bounds lanes; wasm
+    // loads and stores have no alignment requirement
+    unsafe fn mul_add4(acc: v128, term: f32, col: *const f32) -> v128 {
+        f32x4_add(
+            acc,
+            f32x4_mul(f32x4_splat(term), v128_load(col as *const v128)),
+        )
+    }
+
+    unsafe fn first4(term: f32, col: *const f32) -> v128 {
+        f32x4_mul(f32x4_splat(term), v128_load(col as *const v128))
+    }
+
+    pub(super) fn group_simd128(
+        m: &BlockMatrices,
+        state: &[f32; STATES],
+        x: &[f32; GROUP],
+        y: &mut [f32; GROUP],
+        next: &mut [f32; STATES],
+    ) {
+        unsafe {
+            for half in [0, 4] {
+                let mut acc = first4(x[0], m.d[0].as_ptr().add(half));
+                for j in 1..GROUP {
+                    acc = mul_add4(acc, x[j], m.d[j].as_ptr().add(half));
+                }
+                for i in 0..STATES {
+                    acc = mul_add4(acc, state[i], m.c[i].as_ptr().add(half));
+                }
+                v128_store(y.as_mut_ptr().add(half) as *mut v128, acc);
+            }
+
+            let mut acc = first4(x[0], m.b[0].as_ptr());
+            for j in 1..GROUP {
+                acc = mul_add4(acc, x[j], m.b[j].as_ptr());
+            }
+            for i in 0..STATES {
+                acc = mul_add4(acc, state[i], m.a[i].as_ptr());
+            }
+            v128_store(next.as_mut_ptr() as *mut v128, acc);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn test_signal(len: usize) -> Vec<f32> {
+        (0..len)
+            .map(|i| ((i * 7919) % 1000) as f32 / 500.0 - 1.0 + (i as f32 * 0.05).sin())
+            .collect()
+    }
+
+    #[test]
+    fn test_cascade_matches_reference_filters() {
+        let input = test_signal(20_000);
+        let sections = [
+            BiquadFilter::new_highpass(20.0, 44100.0),
+            BiquadFilter::new_lowpass(3000.0, 44100.0),
+        ];
+
+        // Double-precision per-sample reference
+        let mut state = [0.0; STATES];
+        let expected: Vec<f64> = input
+            .iter()
+            .map(|&x| {
+                let (first, second) = state.split_at_mut(2);
+                let y = sections[0].step(first, x as f64);
+                sections[1].step(second, y)
+            })
+            .collect();
+
+        let mut reference = None;
+        for simd in [SimdLevel::Scalar, SimdLevel::detect()] {
+            let mut cascade = FilterCascade::new(20.0, 3000.0, 44100.0);
+            cascade.simd = simd;
+
+            // Uneven block sizes exercise partial groups
+            let mut output = input.clone();
+            let mut start = 0;
+            for len in [1, 3, 8, 13, 500, 19_475] {
+                cascade.process(&mut output[start..start + len]);
+                start += len;
+            }
+
+            for (a, b) in output.iter().zip(&expected) {
+                assert!((*a as f64 - b).abs() < 5e-4, "{:?}: {} vs {}", simd, a, b);
+            }
+
+            // Every instruction set and every block split gives the same bits
+            let reference = reference.get_or_insert_with(|| output.clone());
+            assert_eq!(&output, reference, "{:?}", simd);
+        }
+    }
+
+    #[test]
+    fn test_ring_out_settles_to_silence() {
+        let mut cascade = FilterCascade::new(20.0, 20000.0, 44100.0);
+        let mut reference = cascade.clone();
+        let mut tone = test_signal(1000);
+        cascade.process(&mut tone.clone());
+        reference.process(&mut tone);
+
+        // Ringing decays within a fraction of a second and then stays exactly zero
+        let mut silence = vec![1.0; 44100];
+        let ringing = cascade.ring_out(&mut silence);
+        assert!(ringing < silence.len() && cascade.is_settled());
+        assert!(ringing <= cascade.settle_samples());
+        assert_eq!((1000 + ringing) % GROUP, 0);
+        cascade.skip_silence(silence.len() - ringing);
+
+        let mut filtered_zeros = vec![0.0; 44100];
+        reference.process(&mut filtered_zeros);
+        for (a, b) in silence[..ringing].iter().zip(&filtered_zeros) {
+            assert_eq!(a, b);
+        }
+        assert!(filtered_zeros[ringing..]
+            .iter()
+            .all(|v| v.abs() < SETTLE_THRESHOLD * 10.0));
+    }
+
+    #[test]
+    fn test_cascade_bypass() {
+        let mut cascade = FilterCascade::new(0.0, 30000.0, 44100.0);
+        let input = test_signal(100);
+        let mut output = input.clone();
+        cascade.process(&mut output);
+        assert_eq!(output, input);
+    }
+}
@@ -1,4 +1,4 @@
-use crate::patterns::get_morse_pattern;
+use crate::patterns::{get_morse_character, MorsePatternCode};
 use crate::types::*;
 
 /// Timing statistics for adaptive analysis
@@ -251,7 +251,7 @@ enum GapType {
 #[derive(Debug)]
 enum ParseState {
     Idle,
-    InCharacter(Vec<MorseElementType>),
+    InCharacter(MorsePatternCode),
     BetweenCharacters,
 }
 
@@ -287,15 +287,16 @@ fn parse_morse_signals(
                 let element = timings.classify_element(signal.seconds);
                 match state {
                     ParseState::Idle | ParseState::BetweenCharacters => {
-                        state = ParseState::InCharacter(vec![element]);
+                        state =
+                            ParseState::InCharacter(pattern_of(MorsePatternCode::EMPTY, element));
                     }
                     ParseState::InCharacter(ref mut pattern) => {
-                        pattern.push(element);
+                        *pattern = pattern_of(*pattern, element);
 
                         // Prevent patterns from getting too long
                         if pattern.len() > 7 {
                             // Force character completion for very long patterns
-                            if let Some(ch) = pattern_to_character(pattern) {
+                            if let Some(ch) = pattern_to_character(*pattern) {
                                 result.text.push(ch);
                                 recognized_patterns += 1;
                             }
@@ -318,7 +319,7 @@ fn parse_morse_signals(
                             }
                             GapType::InterCharacter => {
                                 // End of character
-                                if let Some(ch) = pattern_to_character(pattern) {
+                                if let Some(ch) = pattern_to_character(*pattern) {
                                     result.text.push(ch);
                                     recognized_patterns += 1;
                                 }
@@ -327,7 +328,7 @@ fn parse_morse_signals(
                             }
                             GapType::Word => {
                                 // End of character and word
-                                if let Some(ch) = pattern_to_character(pattern) {
+                                if let Some(ch) = pattern_to_character(*pattern) {
                                     result.text.push(ch);
                                     recognized_patterns += 1;
                                 }
@@ -354,7 +355,7 @@ fn parse_morse_signals(
 
     // Handle any remaining pattern in final state
     if let ParseState::InCharacter(pattern) = state {
-        if let Some(ch) = pattern_to_character(&pattern) {
+        if let Some(ch) = pattern_to_character(pattern) {
             result.text.push(ch);
             recognized_patterns += 1;
         }
@@ -373,23 +374,15 @@ fn parse_morse_signals(
     result
 }
 
-/// Convert a morse pattern to character using the existing lookup table
-fn pattern_to_character(pattern: &[MorseElementType]) -> Option<char> {
-    // Create reverse lookup map (pattern -> character)
-    // This is inefficient for production but works for prototype
-    for ch in 0u8..=255u8 {
-        if let Some(stored_pattern) = get_morse_pattern(ch) {
-            if stored_pattern.len() == pattern.len()
-                && stored_pattern
-                    .iter()
-                    .zip(pattern.iter())
-                    .all(|(a, b)| a == b)
-            {
-                return Some(ch as char);
-            }
-        }
-    }
-    None
+// Append a classified element to a pattern. Past the longest packable pattern the element
+// is dropped; any pattern that long is already too long to be a character.
+fn pattern_of(pattern: MorsePatternCode, element: MorseElementType) -> MorsePatternCode {
+    pattern.push(element).unwrap_or(pattern)
+}
+
+/// Convert a morse pattern to character with the packed reverse lookup table
+fn pattern_to_character(pattern: MorsePatternCode) -> Option<char> {
+    get_morse_character(pattern).map(char::from)
 }
 
 /// Main morse interpretation function
@@ -2,16 +2,38 @@
 // Rust port of the original C implementation with WebAssembly bindings
 
 pub mod audio;
+mod channel;
+mod filter;
 pub mod interpret;
+pub mod mixer;
+#[cfg(feature = "parallel")]
+mod parallel;
 pub mod patterns;
+pub mod pcm;
+mod reverb;
+mod spectral;
 pub mod timing;
 pub mod types;
+pub mod wav;
 
 // Re-export main public API
-pub use audio::{morse_audio, morse_audio_size};
+pub use audio::{
+    morse_audio, morse_audio_g711, morse_audio_g711_into, morse_audio_into, morse_audio_pcm16,
+    morse_audio_pcm16_into, morse_audio_size, morse_audio_window, morse_audio_window_into,
+    MorseAudioSegment, MorseAudioStream, WINDOW_TOLERANCE,
+};
+#[cfg(feature = "parallel")]
+pub use audio::{morse_audio_parallel, morse_audio_parallel_into, PARALLEL_TOLERANCE};
 pub use interpret::morse_interpret;
-pub use timing::{morse_timing, morse_timing_size};
+pub use mixer::{morse_mix, morse_mix_into, morse_mix_size, morse_mix_spectral, MorseMixStream};
+pub use timing::{
+    morse_size, morse_symbols, morse_timing, morse_timing_batch, morse_timing_from_symbols,
+    morse_timing_size, MorseSymbolIter, MorseTimingBatch, MorseTimingIter, MorseTimingSession,
+};
+#[cfg(feature = "parallel")]
+pub use timing::{morse_timing_batch_parallel, morse_timing_parallel};
 pub use types::*;
+pub use wav::{morse_audio_wav, WavSampleFormat, WavWriter};
 
 // Public API for direct Rust usage
 pub fn generate_morse_timing(
@@ -0,0 +1,505 @@
+use crate::audio::{
+    element_samples, morse_audio_size, MorseAudioSegment, MorseAudioStream, WhiteNoise, ATTACK_MS,
+    STATIC_SEED,
+};
+use crate::channel::Interference;
+use crate::filter::FilterCascade;
+use crate::spectral::{Carrier, SpectralBank};
+use crate::timing::{morse_size, morse_timing};
+use crate::types::{
+    MorseAudioMode, MorseAudioParams, MorseElement, MorseElementType, MorseMixSynthesis,
+    MorseStation, MorseWaveformType,
+};
+use std::vec::IntoIter;
+
+const VOICE_BLOCK: usize = 1024; // Samples a station renders ahead of the mix
+const STATION_SEED_STEP: u32 = 0x9E37_79B9; // Channel seed offset from one station to the next
+
+// One station: a dry, unfiltered radio stream consumed segment by segment, so the gaps between
+// its elements (and the wait before it starts) cost nothing
+struct Voice {
+    stream: MorseAudioStream<IntoIter<MorseElement>>,
+    buffer: Vec<f32>,
+    pending: (usize, usize), // Rendered samples not yet mixed, as a range of `buffer`
+    silence: usize,          // Silent samples still to pass before the next segment
+    finished: bool,
+}
+
+impl Voice {
+    fn new(
+        station: &MorseStation,
+        index: usize,
+        params: &MorseAudioParams,
+        sample_rate: f32,
+    ) -> Result<(Self, usize), String> {
+        let elements = morse_timing(&station.text, &station.timing_params)?;
+
+        let mut voice_params = params.clone();
+        voice_params.volume = params.volume * station.level;
+        voice_params.high_pass_cutoff = 0.0; // Filtering and static belong to the shared stage
+        voice_params.low_pass_cutoff = sample_rate;
+        voice_params.radio_params.freq_hz = station.freq_hz;
+        voice_params.radio_params.background_static_level = 0.0;
+        // Each station fades on its own path; interference is heard once, at the receiver
+        let channel = &mut voice_params.radio_params.channel;
+        channel.seed = channel
+            .seed
+            .wrapping_add((index as u32).wrapping_mul(STATION_SEED_STEP));
+        channel.qrn_level = 0.0;
+        channel.qrm_level = 0.0;
+
+        let offset = (station.start_seconds.max(0.0) * sample_rate) as usize;
+        let samples = morse_audio_size(&elements, &voice_params)?;
+        let stream = MorseAudioStream::from_elements(elements, &voice_params)?;
+
+        let voice = Self {
+            stream,
+            buffer: vec![0.0; VOICE_BLOCK],
+            pending: (0, 0),
+            silence: offset,
+            finished: false,
+        };
+        Ok((voice, offset + samples))
+    }
+
+    // Fetch the next segment if everything rendered has been mixed. Returns whether the
+    // station is silent from here, and for how many samples that holds.
+    fn peek(&mut self) -> (bool, usize) {
+        while !self.finished && self.silence == 0 && self.pending.0 == self.pending.1 {
+            match self.stream.next_segment(&mut self.buffer) {
+                Some(MorseAudioSegment::Silence(samples)) => self.silence = samples,
+                Some(MorseAudioSegment::Samples(samples)) => self.pending = (0, samples.len()),
+                None => self.finished = true,
+            }
+        }
+
+        if self.finished {
+            (true, usize::MAX)
+        } else if self.silence > 0 {
+            (true, self.silence)
+        } else {
+            (false, self.pending.1 - self.pending.0)
+        }
+    }
+
+    // Add the station's next `block.len()` samples into `block`; `peek` must have promised them
+    fn mix_into(&mut self, block: &mut [f32]) {
+        if self.finished {
+            return;
+        }
+        if self.silence > 0 {
+            self.silence -= block.len();
+            return;
+        }
+
+        let (from, to) = (self.pending.0, self.pending.0 + block.len());
+        for (out, &sample) in block.iter_mut().zip(&self.buffer[from..to]) {
+            *out += sample;
+        }
+        self.pending.0 = to;
+    }
+}
+
+// A station's keyed stretches for the spectral engine, and the sample at which it ends
+fn spectral_carrier(
+    station: &MorseStation,
+    params: &MorseAudioParams,
+    sample_rate: f32,
+) -> Result<(Carrier, usize), String> {
+    if station.freq_hz <= 0.0 || station.freq_hz > 20000.0 || station.freq_hz >= sample_rate / 2.0 {
+        return Err("Invalid frequency".to_string());
+    }
+
+    let mut position = (station.start_seconds.max(0.0) * sample_rate) as usize;
+    let mut keyed = Vec::new();
+    for element in morse_timing(&station.text, &station.timing_params)? {
+        let samples = element_samples(element.duration_seconds, sample_rate);
+        if element.element_type != MorseElementType::Gap && samples > 0 {
+            keyed.push((position as u64, (position + samples) as u64));
+        }
+        position += samples;
+    }
+
+    let carrier = Carrier {
+        freq_hz: station.freq_hz,
+        level: (params.volume * station.level).clamp(0.0, 1.0),
+        keyed,
+    };
+    Ok((carrier, position))
+}
+
+// Where the carriers of a mix come from
+enum Carriers {
+    Oscillators(Vec<Voice>),
+    Spectral(Box<SpectralBank>),
+}
+
+// The receiver every station is heard through: QRN, QRM and static, then the band filters
+struct Receiver {
+    filters: FilterCascade,
+    interference: Option<Interference>,
+    static_noise: WhiteNoise,
+    static_scale: f32,
+}
+
+impl Receiver {
+    // Whether the receiver adds nothing of its own to silent input
+    fn is_quiet(&self) -> bool {
+        self.static_scale <= 0.0 && self.interference.is_none()
+    }
+
+    // Add interference and static to the summed carriers in `block`, which starts at sample
+    // `start`, and filter
+    fn process(&mut self, block: &mut [f32], start: u64) {
+        if let Some(interference) = &self.interference {
+            interference.add_to(block, start);
+        }
+        if self.static_scale > 0.0 {
+            self.static_noise.add_to(start, self.static_scale, block);
+        }
+        self.filters.process(block);
+    }
+
+    // Output for silent input: the filters ring out, then the rest is skipped as in
+    // `MorseAudioStream`
+    fn silence(&mut self, block: &mut [f32]) {
+        let ringing = self.filters.ring_out(block);
+        if ringing < block.len() {
+            block[ringing..].fill(0.0);
+            self.filters.skip_silence(block.len() - ringing);
+        }
+    }
+}
+
+// Oscillator synthesis of `out`, which starts at sample `start`. The block is cut wherever a
+// station starts or stops sounding; where none is and the receiver is quiet, its
+// silence path runs, so a lone station mixes to exactly the samples `morse_audio` gives.
+fn mix_voices(voices: &mut [Voice], receiver: &mut Receiver, out: &mut [f32], start: u64) {
+    let mut done = 0;
+
+    while done < out.len() {
+        let mut run = out.len() - done;
+        let mut silent = receiver.is_quiet();
+        for voice in voices.iter_mut() {
+            let (quiet, samples) = voice.peek();
+            run = run.min(samples);
+            silent &= quiet;
+        }
+
+        let block = &mut out[done..done + run];
+        if silent {
+            receiver.silence(block);
+            for voice in voices.iter_mut() {
+                voice.mix_into(block);
+            }
+        } else {
+            block.fill(0.0);
+            for voice in voices.iter_mut() {
+                voice.mix_into(block);
+            }
+            receiver.process(block, start + done as u64);
+        }
+
+        done += run;
+    }
+}
+
+/// Streaming renderer for several stations on one receiver, as in a pileup or contest.
+///
+/// Every station is keyed at its own frequency, level and start offset, and fades on its own
+/// path when the channel fades; their sum then gets the channel's QRN and QRM, static and
+/// filtering once, exactly as a single signal does in `morse_audio`. QRM is offset from the
+/// radio frequency of `params`. Radio mode only.
+///
+/// With `MorseMixSynthesis::Oscillator` each station has its own oscillator and a lone station
+/// renders exactly as `morse_audio` would. `MorseMixSynthesis::Spectral` draws all carriers into
+/// overlapping inverse-FFT frames instead, so its cost barely grows with the number of stations;
+/// it is the choice for a whole band of signals. Its keying edges are raised cosines about as
+/// long as the oscillators' attack and release, centred on the key transitions.
+pub struct MorseMixStream {
+    carriers: Carriers,
+    receiver: Receiver,
+    sample_index: u64,
+    total_samples: u64,
+}
+
+impl MorseMixStream {
+    /// Create a mix with one oscillator per station
+    pub fn new(stations: &[MorseStation], params: &MorseAudioParams) -> Result<Self, String> {
+        Self::with_synthesis(stations, params, MorseMixSynthesis::Oscillator)
+    }
+
+    /// Create a mix whose carriers come from `synthesis`
+    pub fn with_synthesis(
+        stations: &[MorseStation],
+        params: &MorseAudioParams,
+        synthesis: MorseMixSynthesis,
+    ) -> Result<Self, String> {
+        check_mix_params(params)?;
+
+        let sample_rate = params.sample_rate as f32;
+        let mut total_samples = 0;
+        let carriers = match synthesis {
+            MorseMixSynthesis::Oscillator => {
+                let mut voices = Vec::with_capacity(stations.len());
+                for (index, station) in stations.iter().enumerate() {
+                    let (voice, samples) = Voice::new(station, index, params, sample_rate)?;
+                    voices.push(voice);
+                    total_samples = total_samples.max(samples);
+                }
+                Carriers::Oscillators(voices)
+            }
+            MorseMixSynthesis::Spectral => {
+                if params.radio_params.waveform_type != MorseWaveformType::Sine {
+                    return Err("Spectral synthesis requires a sine carrier".to_string());
+                }
+                let channel = &params.radio_params.channel;
+                if channel.fading_spread_hz > 0.0 || channel.qsb_depth > 0.0 {
+                    return Err("Spectral synthesis does not model fading".to_string());
+                }
+
+                let mut carriers = Vec::with_capacity(stations.len());
+                for station in stations {
+                    let (carrier, samples) = spectral_carrier(station, params, sample_rate)?;
+                    carriers.push(carrier);
+                    total_samples = total_samples.max(samples);
+                }
+                Carriers::Spectral(Box::new(SpectralBank::new(
+                    carriers,
+                    sample_rate,
+                    ATTACK_MS,
+                )))
+            }
+        };
+
+        let volume = params.volume.clamp(0.0, 1.0);
+        let interference = Interference::new(
+            &params.radio_params.channel,
+            params.radio_params.freq_hz,
+            volume,
+            sample_rate,
+        )?;
+
+        Ok(Self {
+            carriers,
+            receiver: Receiver {
+                filters: FilterCascade::new(
+                    params.high_pass_cutoff,
+                    params.low_pass_cutoff,
+                    sample_rate,
+                ),
+                interference,
+                static_noise: WhiteNoise::new(STATIC_SEED),
+                static_scale: params.radio_params.background_static_level * volume,
+            },
+            sample_index: 0,
+            total_samples: total_samples as u64,
+        })
+    }
+
+    /// Length of the mix: until the last station finishes
+    pub fn total_samples(&self) -> usize {
+        self.total_samples as usize
+    }
+
+    /// Fill `out` with the next block of the mix.
+    /// Returns the number of samples written, which is less than `out.len()` only at the end.
+    pub fn fill(&mut self, out: &mut [f32]) -> usize {
+        let count = ((self.total_samples - self.sample_index) as usize).min(out.len());
+        let block = &mut out[..count];
+
+        match &mut self.carriers {
+            Carriers::Oscillators(voices) => {
+                mix_voices(voices, &mut self.receiver, block, self.sample_index)
+            }
+            Carriers::Spectral(bank) => {
+                bank.render(block);
+                self.receiver.process(block, self.sample_index);
+            }
+        }
+
+        self.sample_index += count as u64;
+        count
+    }
+}
+
+/// Render several stations into one buffer
+pub fn morse_mix(stations: &[MorseStation], params: &MorseAudioParams) -> Result<Vec<f32>, String> {
+    let mut stream = MorseMixStream::new(stations, params)?;
+    let mut samples = vec![0.0; stream.total_samples()];
+    stream.fill(&mut samples);
+    Ok(samples)
+}
+
+/// Render several stations into one buffer with spectral synthesis, for large numbers of them
+pub fn morse_mix_spectral(
+    stations: &[MorseStation],
+    params: &MorseAudioParams,
+) -> Result<Vec<f32>, String> {
+    let mut stream = MorseMixStream::with_synthesis(stations, params, MorseMixSynthesis::Spectral)?;
+    let mut samples = vec![0.0; stream.total_samples()];
+    stream.fill(&mut samples);
+    Ok(samples)
+}
+
+// Parameters every mix needs, whatever its stations
+fn check_mix_params(params: &MorseAudioParams) -> Result<(), String> {
+    if params.sample_rate <= 0 || params.sample_rate > 192000 {
+        return Err("Invalid sample rate".to_string());
+    }
+    if params.audio_mode != MorseAudioMode::Radio {
+        return Err("Station mixing requires radio mode".to_string());
+    }
+    Ok(())
+}
+
+/// Render several stations into a caller-provided buffer.
+/// The buffer must hold at least `morse_mix_size` samples; returns the number written.
+pub fn morse_mix_into(
+    stations: &[MorseStation],
+    params: &MorseAudioParams,
+    out: &mut [f32],
+) -> Result<usize, String> {
+    let mut stream = MorseMixStream::new(stations, params)?;
+    if out.len() < stream.total_samples() {
+        return Err("Output buffer too small".to_string());
+    }
+    Ok(stream.fill(out))
+}
+
+/// Calculate the number of samples in the mix of `stations`
+pub fn morse_mix_size(
+    stations: &[MorseStation],
+    params: &MorseAudioParams,
+) -> Result<usize, String> {
+    check_mix_params(params)?;
+
+    let sample_rate = params.sample_rate as f32;
+    let mut total_samples = 0;
+    for station in stations {
+        let offset = (station.start_seconds.max(0.0) * sample_rate) as usize;
+        let size = morse_size(&station.text, &station.timing_params, params)?;
+        total_samples = total_samples.max(offset + size.samples);
+    }
+    Ok(total_samples)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::audio::morse_audio;
+    use crate::types::MorseTimingParams;
+
+    fn station(text: &str, wpm: i32, freq_hz: f32, start_seconds: f32) -> MorseStation {
+        MorseStation {
+            text: text.to_string(),
+            timing_params: MorseTimingParams {
+                wpm,
+                ..Default::default()
+            },
+            freq_hz,
+            level: 1.0,
+            start_seconds,
+        }
+    }
+
+    #[test]
+    fn test_single_station_matches_morse_audio() {
+        let single = station("CQ TEST", 25, 700.0, 0.0);
+
+        for static_level in [0.0, 0.1] {
+            let mut params = MorseAudioParams {
+                sample_rate: 8000,
+                ..Default::default()
+            };
+            params.radio_params.freq_hz = single.freq_hz;
+            params.radio_params.background_static_level = static_level;
+
+            let elements = morse_timing(&single.text, &single.timing_params).unwrap();
+            let expected = morse_audio(&elements, &params).unwrap();
+
+            let mut stream = MorseMixStream::new(std::slice::from_ref(&single), &params).unwrap();
+            let mut mixed = vec![0.0; expected.len() + 100];
+            let mut written = 0;
+            for block in [1, 333, 4096].iter().cycle() {
+                let end = (written + block).min(mixed.len());
+                let count = stream.fill(&mut mixed[written..end]);
+                if count < end - written {
+                    written += count;
+                    break;
+                }
+                written += count;
+            }
+
+            assert_eq!(written, expected.len());
+            assert_eq!(&mixed[..written], &expected[..]);
+        }
+    }
+
+    #[test]
+    fn test_stations_sum_at_their_offsets() {
+        let stations = [
+            station("DL1ABC", 28, 650.0, 0.0),
+            station("K1XYZ", 22, 820.0, 0.35),
+        ];
+        let params = MorseAudioParams {
+            sample_rate: 8000,
+            high_pass_cutoff: 0.0,
+            low_pass_cutoff: 8000.0,
+            ..Default::default()
+        };
+
+        let mixed = morse_mix(&stations, &params).unwrap();
+        assert_eq!(mixed.len(), morse_mix_size(&stations, &params).unwrap());
+
+        let mut expected = vec![0.0f32; mixed.len()];
+        for s in &stations {
+            let mut own = params.clone();
+            own.radio_params.freq_hz = s.freq_hz;
+            let elements = morse_timing(&s.text, &s.timing_params).unwrap();
+            let offset = (s.start_seconds * 8000.0) as usize;
+            for (k, sample) in morse_audio(&elements, &own)
+                .unwrap()
+                .into_iter()
+                .enumerate()
+            {
+                expected[offset + k] += sample;
+            }
+        }
+        assert_eq!(mixed, expected);
+
+        let mut telegraph = params.clone();
+        telegraph.audio_mode = MorseAudioMode::Telegraph;
+        assert!(morse_mix(&stations, &telegraph).is_err());
+        assert!(morse_mix_size(&stations, &telegraph).is_err());
+        let fast = MorseAudioParams {
+            sample_rate: 384000,
+            ..params
+        };
+        assert!(morse_mix_size(&stations, &fast).is_err());
+    }
+
+    #[test]
+    fn test_spectral_synthesis_tracks_oscillators() {
+        let stations: Vec<MorseStation> = (0..12)
+            .map(|i| station("TEST", 20 + i, 450.0 + 130.0 * i as f32, 0.05 * i as f32))
+            .collect();
+        let params = MorseAudioParams {
+            sample_rate: 8000,
+            ..Default::default()
+        };
+
+        let oscillators = morse_mix(&stations, &params).unwrap();
+        let spectral = morse_mix_spectral(&stations, &params).unwrap();
+        assert_eq!(spectral.len(), oscillators.len());
+
+        // Same carriers, keyed alike; only the keying edges differ
+        let energy = |samples: &[f32]| samples.iter().map(|&s| s * s).sum::<f32>();
+        let ratio = energy(&spectral) / energy(&oscillators);
+        assert!((ratio - 1.0).abs() < 0.05, "energy ratio {ratio}");
+
+        let mut square = params.clone();
+        square.radio_params.waveform_type = MorseWaveformType::Square;
+        assert!(morse_mix_spectral(&stations, &square).is_err());
+    }
+}
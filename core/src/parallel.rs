@@ -0,0 +1,31 @@
+// Work distribution for the opt-in multi-core renderers
+use std::sync::Mutex;
+use std::thread;
+
+/// Number of worker threads to use
+pub(crate) fn thread_count() -> usize {
+    thread::available_parallelism().map_or(1, |n| n.get())
+}
+
+/// Run `work` on every task, spread over up to `thread_count()` scoped threads. Tasks are handed
+/// out in order from a shared queue, so uneven task sizes still balance.
+pub(crate) fn run_parallel<T: Send>(tasks: Vec<T>, work: impl Fn(T) + Sync) {
+    let threads = thread_count().min(tasks.len());
+    if threads <= 1 {
+        tasks.into_iter().for_each(work);
+        return;
+    }
+
+    let queue = Mutex::new(tasks.into_iter());
+    thread::scope(|scope| {
+        for _ in 0..threads {
+            scope.spawn(|| loop {
+                let task = queue.lock().unwrap().next();
+                match task {
+                    Some(task) => work(task),
+                    None => break,
+                }
+            });
+        }
+    });
+}
@@ -162,7 +162,178 @@ static MORSE_PATTERNS: [Option<MorsePattern>; 256] = {
     patterns
 };
 
+/// Size of a character's pattern: its elements, counting the gaps between them, and its
+/// length in dot units
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct MorsePatternSize {
+    pub elements: u8,
+    pub dot_units: u8,
+}
+
+/// A pattern packed into 16 bits: one bit per element from the lowest bit up, 1 for a dash,
+/// then a marker bit. `.-` is 0b110 and the empty pattern is 1, so the length is the position
+/// of the marker, the next element to send is always bit 0, and patterns of up to 7 elements
+/// index a 256-entry table directly.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct MorsePatternCode(u16);
+
+impl MorsePatternCode {
+    pub const EMPTY: Self = Self(1);
+    pub const MAX_LEN: usize = 15;
+
+    /// Pack a pattern of at most MAX_LEN elements
+    pub const fn from_pattern(pattern: MorsePattern) -> Self {
+        let mut code = Self::EMPTY;
+        let mut i = 0;
+        while i < pattern.len() {
+            code = match code.push(pattern[i]) {
+                Some(code) => code,
+                None => panic!("Pattern too long to pack"),
+            };
+            i += 1;
+        }
+        code
+    }
+
+    /// Number of elements
+    pub const fn len(self) -> usize {
+        15 - self.0.leading_zeros() as usize
+    }
+
+    pub const fn is_empty(self) -> bool {
+        self.0 == 1
+    }
+
+    /// The raw bits, marker included
+    pub const fn bits(self) -> u16 {
+        self.0
+    }
+
+    /// The pattern with `element` appended, or None past MAX_LEN elements
+    pub const fn push(self, element: MorseElementType) -> Option<Self> {
+        if self.len() == Self::MAX_LEN {
+            return None;
+        }
+        let len = self.len();
+        let dash = matches!(element, MorseElementType::Dash) as u16;
+        Some(Self((self.0 ^ 1 << len) | dash << len | 1 << (len + 1)))
+    }
+
+    /// The first element and the rest of the pattern, or None when empty
+    pub const fn split_first(self) -> Option<(MorseElementType, Self)> {
+        if self.0 == 1 {
+            return None;
+        }
+        let element = match self.0 & 1 {
+            1 => MorseElementType::Dash,
+            _ => MorseElementType::Dot,
+        };
+        Some((element, Self(self.0 >> 1)))
+    }
+
+    /// Number of dashes
+    pub const fn dashes(self) -> usize {
+        (self.0 & !(1 << self.len())).count_ones() as usize
+    }
+}
+
+// Packed patterns by byte
+static MORSE_PATTERN_CODES: [Option<MorsePatternCode>; 256] = {
+    let mut codes = [None; 256];
+    let mut ch = 0;
+    while ch < 256 {
+        if let Some(pattern) = MORSE_PATTERNS[ch] {
+            codes[ch] = Some(MorsePatternCode::from_pattern(pattern));
+        }
+        ch += 1;
+    }
+    codes
+};
+
+// Reverse table: the character of each packed pattern of up to 7 elements. Where several bytes
+// share a pattern (upper and lower case) the lowest one, the uppercase letter, is kept.
+static MORSE_CODE_CHARACTERS: [Option<u8>; 256] = {
+    let mut characters = [None; 256];
+    let mut ch = 256;
+    while ch > 0 {
+        ch -= 1;
+        if let Some(code) = MORSE_PATTERN_CODES[ch] {
+            characters[code.0 as usize] = Some(ch as u8);
+        }
+    }
+    characters
+};
+
+// Pattern sizes by byte, so text can be sized without walking the patterns
+static MORSE_PATTERN_SIZES: [Option<MorsePatternSize>; 256] = {
+    let mut sizes = [None; 256];
+    let mut ch = 0;
+    while ch < 256 {
+        if let Some(code) = MORSE_PATTERN_CODES[ch] {
+            let len = code.len();
+            sizes[ch] = Some(MorsePatternSize {
+                elements: (2 * len - 1) as u8,
+                dot_units: (2 * len - 1 + 2 * code.dashes()) as u8, // Dashes are 3 dots long
+            });
+        }
+        ch += 1;
+    }
+    sizes
+};
+
 /// Get morse pattern for a character - O(1) lookup
-pub fn get_morse_pattern(ch: u8) -> Option<MorsePattern> {
+pub const fn get_morse_pattern(ch: u8) -> Option<MorsePattern> {
     MORSE_PATTERNS[ch as usize]
 }
+
+/// Get the size of a character's pattern - O(1) lookup
+pub const fn get_morse_pattern_size(ch: u8) -> Option<MorsePatternSize> {
+    MORSE_PATTERN_SIZES[ch as usize]
+}
+
+/// Get the packed pattern for a character - O(1) lookup
+pub const fn get_morse_pattern_code(ch: u8) -> Option<MorsePatternCode> {
+    MORSE_PATTERN_CODES[ch as usize]
+}
+
+/// Get the character sent as a packed pattern - O(1) lookup
+pub const fn get_morse_character(code: MorsePatternCode) -> Option<u8> {
+    if code.0 as usize >= MORSE_CODE_CHARACTERS.len() {
+        return None;
+    }
+    MORSE_CODE_CHARACTERS[code.0 as usize]
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_pattern_codes_round_trip() {
+        for ch in 0..=255u8 {
+            let (Some(pattern), Some(code)) = (get_morse_pattern(ch), get_morse_pattern_code(ch))
+            else {
+                assert!(get_morse_pattern_code(ch).is_none());
+                continue;
+            };
+
+            // Unpacking gives the pattern back
+            let (mut unpacked, mut rest) = (Vec::new(), code);
+            while let Some((element, tail)) = rest.split_first() {
+                unpacked.push(element);
+                rest = tail;
+            }
+            assert_eq!(unpacked, pattern);
+            assert_eq!(code.len(), pattern.len());
+
+            // Decoding gives the character, folded to upper case
+            assert_eq!(get_morse_character(code), Some(ch.to_ascii_uppercase()));
+        }
+
+        assert_eq!(MorsePatternCode::from_pattern(&[DOT, DASH]).bits(), 0b110);
+        assert_eq!(get_morse_character(MorsePatternCode::EMPTY), None);
+        let long = MorsePatternCode::from_pattern(&[DOT; MorsePatternCode::MAX_LEN]);
+        assert_eq!(long.push(DOT), None);
+        assert_eq!(get_morse_character(long), None);
+    }
+}
@@ -0,0 +1,120 @@
+// G.711 companding of 16-bit linear PCM (segment encoders as in the ITU reference)
+use crate::types::MorseG711Law;
+
+const MULAW_BIAS: i32 = 0x84 >> 2; // Bias in 14-bit units
+const MULAW_CLIP: i32 = 8159;
+const MULAW_SEGMENT_END: [i32; 8] = [0x3F, 0x7F, 0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF, 0x1FFF];
+const ALAW_SEGMENT_END: [i32; 8] = [0x1F, 0x3F, 0x7F, 0xFF, 0x1FF, 0x3FF, 0x7FF, 0xFFF];
+
+// Index of the first segment whose end is at least `value`, or 8 past the last one
+fn segment(value: i32, ends: &[i32; 8]) -> i32 {
+    ends.iter().position(|&end| value <= end).unwrap_or(8) as i32
+}
+
+/// Encode a 16-bit linear sample as G.711 µ-law
+pub fn linear_to_mulaw(sample: i16) -> u8 {
+    let mut value = sample as i32 >> 2;
+    let mask = if value < 0 {
+        value = -value;
+        0x7F
+    } else {
+        0xFF
+    };
+
+    let value = value.min(MULAW_CLIP) + MULAW_BIAS;
+    let seg = segment(value, &MULAW_SEGMENT_END);
+    if seg >= 8 {
+        return (0x7F ^ mask) as u8;
+    }
+
+    (((seg << 4) | ((value >> (seg + 1)) & 0xF)) ^ mask) as u8
+}
+
+/// Encode a 16-bit linear sample as G.711 A-law
+pub fn linear_to_alaw(sample: i16) -> u8 {
+    let mut value = sample as i32 >> 3;
+    let mask = if value >= 0 {
+        0xD5
+    } else {
+        value = -value - 1;
+        0x55
+    };
+
+    let seg = segment(value, &ALAW_SEGMENT_END);
+    if seg >= 8 {
+        return (0x7F ^ mask) as u8;
+    }
+
+    let shift = if seg < 2 { 1 } else { seg };
+    (((seg << 4) | ((value >> shift) & 0xF)) ^ mask) as u8
+}
+
+/// Encode a 16-bit linear sample with the given law
+pub fn linear_to_g711(sample: i16, law: MorseG711Law) -> u8 {
+    match law {
+        MorseG711Law::Mulaw => linear_to_mulaw(sample),
+        MorseG711Law::Alaw => linear_to_alaw(sample),
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    // Reference decoders, used to check the encoders round-trip within a quantisation step
+    fn mulaw_to_linear(code: u8) -> i32 {
+        let code = !code as i32;
+        let magnitude = ((((code & 0xF) << 3) + 0x84) << ((code & 0x70) >> 4)) - 0x84;
+        if code & 0x80 != 0 {
+            -magnitude
+        } else {
+            magnitude
+        }
+    }
+
+    fn alaw_to_linear(code: u8) -> i32 {
+        let code = (code ^ 0x55) as i32;
+        let seg = (code & 0x70) >> 4;
+        let mut magnitude = (code & 0xF) << 4;
+        magnitude += if seg == 0 { 8 } else { 0x108 };
+        if seg > 1 {
+            magnitude <<= seg - 1;
+        }
+        if code & 0x80 != 0 {
+            magnitude
+        } else {
+            -magnitude
+        }
+    }
+
+    #[test]
+    fn test_g711_reference_codes() {
+        assert_eq!(linear_to_mulaw(0), 0xFF);
+        assert_eq!(linear_to_mulaw(i16::MAX), 0x80);
+        assert_eq!(linear_to_mulaw(i16::MIN), 0x00);
+        assert_eq!(linear_to_alaw(0), 0xD5);
+        assert_eq!(linear_to_alaw(i16::MAX), 0xAA);
+        assert_eq!(linear_to_alaw(i16::MIN), 0x2A);
+    }
+
+    #[test]
+    fn test_g711_round_trip() {
+        for sample in (i16::MIN..=i16::MAX).step_by(7) {
+            let linear = sample as i32;
+            // Step size doubles per segment; allow half a step of the segment plus rounding
+            let tolerance = (linear.abs() / 16).max(16) + 8;
+
+            let mulaw = mulaw_to_linear(linear_to_mulaw(sample));
+            assert!(
+                (mulaw - linear).abs() <= tolerance,
+                "µ-law {sample} -> {mulaw}"
+            );
+
+            let alaw = alaw_to_linear(linear_to_alaw(sample));
+            assert!(
+                (alaw - linear).abs() <= tolerance,
+                "A-law {sample} -> {alaw}"
+            );
+        }
+    }
+}
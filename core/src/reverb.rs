@@ -0,0 +1,169 @@
+// Feedback delay network reverb for the telegraph sounder's room
+const LINES: usize = 4;
+const DELAY_MS: [f32; LINES] = [29.7, 37.1, 41.1, 43.7]; // Mutually unrelated, so echoes don't stack
+const DECAY_SEC: f32 = 0.4; // Time for the tail to fall by 60 dB
+const SETTLE_DB: f32 = 120.0; // Tail below this is snapped to exact silence
+
+/// Four delay lines mixed through an orthogonal (Hadamard) feedback matrix.
+///
+/// Every line is a ring buffer as long as its delay, so a sample is read and its replacement
+/// written at the same index. Within a run that doesn't wrap any ring, samples are therefore
+/// independent of each other and the loop vectorises. The lines are allocated once, sized from
+/// the sample rate; processing never allocates.
+///
+/// The network only runs while there is input or a tail: callers announce input with `excite`,
+/// and once the tail has decayed by SETTLE_DB the lines are snapped to zero at that exact
+/// sample, so the result does not depend on block sizes.
+pub(crate) struct Reverb {
+    lines: [Vec<f32>; LINES],
+    position: [usize; LINES],
+    feedback: [f32; LINES], // Per-line gain giving the same decay rate for every line
+    amount: f32,
+    settle_samples: u64,
+    ring_until: u64, // Absolute sample at which the tail is snapped to silence
+}
+
+impl Reverb {
+    /// None when `amount` is zero, so a dry render does no reverb work at all
+    pub(crate) fn new(amount: f32, sample_rate: f32) -> Option<Self> {
+        let amount = amount.clamp(0.0, 1.0);
+        if amount <= 0.0 {
+            return None;
+        }
+
+        let lengths = DELAY_MS.map(|ms| ((ms / 1000.0 * sample_rate) as usize).max(1));
+        let decay_samples = DECAY_SEC * sample_rate;
+
+        Some(Self {
+            lines: lengths.map(|len| vec![0.0; len]),
+            position: [0; LINES],
+            feedback: lengths.map(|len| 10f32.powf(-3.0 * len as f32 / decay_samples)),
+            amount,
+            settle_samples: Self::settle_samples(sample_rate) as u64,
+            ring_until: 0,
+        })
+    }
+
+    /// Samples from the last input until the tail is snapped to silence
+    pub(crate) fn settle_samples(sample_rate: f32) -> usize {
+        (DECAY_SEC * SETTLE_DB / 60.0 * sample_rate) as usize
+    }
+
+    /// Note that input may be non-zero up to absolute sample `until`
+    pub(crate) fn excite(&mut self, until: u64) {
+        self.ring_until = self.ring_until.max(until + self.settle_samples);
+    }
+
+    /// Absolute sample from which the reverb is silent, unless excited again
+    pub(crate) fn ring_until(&self) -> u64 {
+        self.ring_until
+    }
+
+    /// Add the reverb of `block`, which starts at absolute sample `start`, to it in place
+    pub(crate) fn process(&mut self, block: &mut [f32], start: u64) {
+        if start >= self.ring_until {
+            return;
+        }
+
+        let active = ((self.ring_until - start) as usize).min(block.len());
+        let mut done = 0;
+
+        while done < active {
+            let run = (0..LINES)
+                .map(|i| self.lines[i].len() - self.position[i])
+                .fold(active - done, usize::min);
+            self.process_run(&mut block[done..done + run]);
+
+            for i in 0..LINES {
+                self.position[i] = (self.position[i] + run) % self.lines[i].len();
+            }
+            done += run;
+        }
+
+        if start + active as u64 == self.ring_until {
+            for line in &mut self.lines {
+                line.fill(0.0);
+            }
+            self.position = [0; LINES];
+        }
+    }
+
+    // Samples that wrap no ring buffer
+    fn process_run(&mut self, block: &mut [f32]) {
+        let [a, b, c, d] = &mut self.lines;
+        let [pa, pb, pc, pd] = self.position;
+        let len = block.len();
+        let (a, b) = (&mut a[pa..pa + len], &mut b[pb..pb + len]);
+        let (c, d) = (&mut c[pc..pc + len], &mut d[pd..pd + len]);
+        let [ga, gb, gc, gd] = self.feedback.map(|g| g * 0.5); // Hadamard normalisation
+        let wet = self.amount / LINES as f32;
+
+        for k in 0..len {
+            let (sa, sb, sc, sd) = (a[k], b[k], c[k], d[k]);
+            let input = block[k];
+            let (sum_ab, diff_ab) = (sa + sb, sa - sb);
+            let (sum_cd, diff_cd) = (sc + sd, sc - sd);
+
+            a[k] = input + ga * (sum_ab + sum_cd);
+            b[k] = input + gb * (diff_ab + diff_cd);
+            c[k] = input + gc * (sum_ab - sum_cd);
+            d[k] = input + gd * (diff_ab - diff_cd);
+            block[k] = input + (sum_ab + sum_cd) * wet;
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_reverb_tail_decays_and_snaps() {
+        let sample_rate = 8000.0;
+        let mut reverb = Reverb::new(0.5, sample_rate).unwrap();
+        assert!(Reverb::new(0.0, sample_rate).is_none());
+
+        let mut block = vec![0.0; 2 * Reverb::settle_samples(sample_rate)];
+        block[0] = 1.0;
+        reverb.excite(1);
+        reverb.process(&mut block, 0);
+
+        // Dry impulse, then echoes that start after the shortest delay and die away
+        let first_echo = (DELAY_MS[0] / 1000.0 * sample_rate) as usize;
+        assert_eq!(block[0], 1.0);
+        assert!(block[1..first_echo].iter().all(|&s| s == 0.0));
+        assert!(block[first_echo] > 0.0);
+
+        let decay_samples = (DECAY_SEC * sample_rate) as usize;
+        let peak = |range: &[f32]| range.iter().fold(0.0f32, |m, s| m.max(s.abs()));
+        assert!(peak(&block[decay_samples..2 * decay_samples]) < 2e-3);
+
+        let ring_until = reverb.ring_until() as usize;
+        assert!(block[ring_until..].iter().all(|&s| s == 0.0));
+        assert!(reverb.lines.iter().flatten().all(|&s| s == 0.0));
+    }
+
+    #[test]
+    fn test_reverb_independent_of_block_size() {
+        let sample_rate = 8000.0;
+        let mut input = vec![0.0; 4000];
+        for (k, s) in input.iter_mut().enumerate().take(500) {
+            *s = ((k * 37) % 11) as f32 / 11.0 - 0.5;
+        }
+
+        let mut whole = input.clone();
+        let mut reverb = Reverb::new(0.3, sample_rate).unwrap();
+        reverb.excite(500);
+        reverb.process(&mut whole, 0);
+
+        for block in [1, 7, 300] {
+            let mut reverb = Reverb::new(0.3, sample_rate).unwrap();
+            reverb.excite(500);
+            let mut pieces = input.clone();
+            for (n, chunk) in pieces.chunks_mut(block).enumerate() {
+                reverb.process(chunk, (n * block) as u64);
+            }
+            assert_eq!(pieces, whole);
+        }
+    }
+}
@@ -0,0 +1,345 @@
+// Inverse-FFT overlap-add synthesis of many keyed sine carriers
+use std::f64::consts::PI;
+
+const LOBE_BINS: usize = 16; // Bins either side of a carrier that receive its window spectrum
+const LOBE_WIDTH: usize = 2 * LOBE_BINS + 1;
+const LOBE_STEPS: usize = 64; // Window spectrum rows per bin of carrier offset
+const MIN_HOP: usize = 32; // Keeps the frame wider than a carrier's lobe
+
+/// A station as seen by the spectral engine: a carrier keyed on over sample intervals
+pub(crate) struct Carrier {
+    pub(crate) freq_hz: f32,
+    pub(crate) level: f32,
+    pub(crate) keyed: Vec<(u64, u64)>, // Absolute [start, end) sample ranges, in order
+}
+
+impl Carrier {
+    // Keyed samples in [from, to), from a cursor that only moves forwards
+    fn keyed_in(&self, next: &mut usize, from: u64, to: u64) -> u64 {
+        while *next < self.keyed.len() && self.keyed[*next].1 <= from {
+            *next += 1;
+        }
+
+        self.keyed[*next..]
+            .iter()
+            .take_while(|&&(start, _)| start < to)
+            .map(|&(start, end)| end.min(to) - start.max(from))
+            .sum()
+    }
+}
+
+// Unnormalised inverse FFT of power-of-two size on split real and imaginary arrays
+struct InverseFft {
+    bit_reverse: Vec<u32>,
+    twiddle_re: Vec<f32>, // Per stage, contiguous: the stage of half-width h starts at h - 1
+    twiddle_im: Vec<f32>,
+}
+
+impl InverseFft {
+    fn new(size: usize) -> Self {
+        debug_assert!(size.is_power_of_two());
+        let bits = size.trailing_zeros();
+
+        let bit_reverse = (0..size as u32)
+            .map(|i| i.reverse_bits().checked_shr(32 - bits).unwrap_or(0))
+            .collect();
+
+        let mut twiddle_re = Vec::with_capacity(size);
+        let mut twiddle_im = Vec::with_capacity(size);
+        let mut half = 1;
+        while half < size {
+            for j in 0..half {
+                let angle = PI * j as f64 / half as f64;
+                twiddle_re.push(angle.cos() as f32);
+                twiddle_im.push(angle.sin() as f32);
+            }
+            half *= 2;
+        }
+
+        Self {
+            bit_reverse,
+            twiddle_re,
+            twiddle_im,
+        }
+    }
+
+    fn run(&self, re: &mut [f32], im: &mut [f32]) {
+        for (i, &j) in self.bit_reverse.iter().enumerate() {
+            let j = j as usize;
+            if i < j {
+                re.swap(i, j);
+                im.swap(i, j);
+            }
+        }
+
+        let size = re.len();
+        let mut half = 1;
+        while half < size {
+            let w_re = &self.twiddle_re[half - 1..2 * half - 1];
+            let w_im = &self.twiddle_im[half - 1..2 * half - 1];
+
+            for (re, im) in re
+                .chunks_exact_mut(2 * half)
+                .zip(im.chunks_exact_mut(2 * half))
+            {
+                let (a_re, b_re) = re.split_at_mut(half);
+                let (a_im, b_im) = im.split_at_mut(half);
+                for j in 0..half {
+                    let t_re = b_re[j] * w_re[j] - b_im[j] * w_im[j];
+                    let t_im = b_re[j] * w_im[j] + b_im[j] * w_re[j];
+                    b_re[j] = a_re[j] - t_re;
+                    b_im[j] = a_im[j] - t_im;
+                    a_re[j] += t_re;
+                    a_im[j] += t_im;
+                }
+            }
+            half *= 2;
+        }
+    }
+}
+
+/// Synthesises the sum of many keyed carriers a frame at a time.
+///
+/// Frames are 2 * hop samples of Hann-windowed signal, overlapped by half so the windows sum to
+/// exactly one. A carrier is drawn into a frame's spectrum as the window's own spectrum centred
+/// on its (fractional) bin, taken from a table, so each carrier costs a few dozen bins per
+/// frame and the frame costs one inverse FFT however many carriers there are. A carrier's
+/// amplitude in a frame is the keyed fraction of the hop around the frame's centre; the
+/// overlapping windows turn that into raised-cosine keying edges a hop long, with the edge's
+/// midpoint where the key changes.
+pub(crate) struct SpectralBank {
+    carriers: Vec<Carrier>,
+    cursors: Vec<usize>,
+    fft: InverseFft,
+    lobe: Vec<f32>, // LOBE_STEPS + 1 rows of LOBE_WIDTH bins
+    hop: usize,
+    sample_rate: f64,
+    re: Vec<f32>,
+    im: Vec<f32>,
+    ready: Vec<f32>, // Finished samples of the current hop
+    tail: Vec<f32>,  // Second half of the last frame, still missing the next frame's first half
+    consumed: usize,
+    next_center: u64,
+}
+
+impl SpectralBank {
+    pub(crate) fn new(carriers: Vec<Carrier>, sample_rate: f32, edge_ms: f32) -> Self {
+        let hop = ((edge_ms / 1000.0 * sample_rate) as usize)
+            .next_power_of_two()
+            .max(MIN_HOP);
+        let size = 2 * hop;
+
+        let mut bank = Self {
+            cursors: vec![0; carriers.len()],
+            carriers,
+            fft: InverseFft::new(size),
+            lobe: Self::lobe_table(size),
+            hop,
+            sample_rate: sample_rate as f64,
+            re: vec![0.0; size],
+            im: vec![0.0; size],
+            ready: vec![0.0; hop],
+            tail: vec![0.0; hop],
+            consumed: hop,
+            next_center: 0,
+        };
+
+        // The frame centred on sample 0 only leaves its second half
+        bank.synthesise_frame();
+        bank.consumed = hop;
+        bank
+    }
+
+    // Spectrum of the periodic Hann window of `size` samples, centred on the frame, scaled by
+    // 1 / size and sampled at bin offsets j - LOBE_BINS + s / LOBE_STEPS
+    fn lobe_table(size: usize) -> Vec<f32> {
+        let n = size as f64;
+        // Dirichlet kernel over the window's size - 1 non-zero samples
+        let dirichlet = |y: f64| {
+            let denominator = (PI * y / n).sin();
+            if denominator.abs() < 1e-12 {
+                n - 1.0
+            } else {
+                (PI * y * (n - 1.0) / n).sin() / denominator
+            }
+        };
+
+        (0..=LOBE_STEPS)
+            .flat_map(|s| (0..LOBE_WIDTH).map(move |j| (s, j)))
+            .map(|(s, j)| {
+                let x = j as f64 - LOBE_BINS as f64 + s as f64 / LOBE_STEPS as f64;
+                let w = 0.5 * dirichlet(x) + 0.25 * (dirichlet(x - 1.0) + dirichlet(x + 1.0));
+                (w / n) as f32
+            })
+            .collect()
+    }
+
+    /// Write the next `block.len()` samples of the sum into `block`
+    pub(crate) fn render(&mut self, block: &mut [f32]) {
+        let mut done = 0;
+
+        while done < block.len() {
+            if self.consumed == self.hop {
+                self.synthesise_frame();
+            }
+
+            let count = (self.hop - self.consumed).min(block.len() - done);
+            block[done..done + count]
+                .copy_from_slice(&self.ready[self.consumed..self.consumed + count]);
+            self.consumed += count;
+            done += count;
+        }
+    }
+
+    // Add the frame centred on `next_center`, finishing the hop before that centre
+    fn synthesise_frame(&mut self) {
+        let size = self.re.len();
+        let hop = self.hop as u64;
+        let center = self.next_center;
+
+        self.re.fill(0.0);
+        self.im.fill(0.0);
+
+        let from = center.saturating_sub(hop / 2);
+        let to = center + hop / 2;
+        for (carrier, next) in self.carriers.iter().zip(&mut self.cursors) {
+            let keyed = carrier.keyed_in(next, from, to);
+            if keyed == 0 {
+                continue;
+            }
+
+            let amplitude = carrier.level * keyed as f32 / hop as f32;
+            let cycles = carrier.freq_hz as f64 / self.sample_rate;
+            let phase = 2.0 * PI * (cycles * center as f64).fract();
+            let (a_re, a_im) = (
+                amplitude * phase.cos() as f32,
+                amplitude * phase.sin() as f32,
+            );
+
+            // Lowest bin of the lobe, and where the carrier falls between table rows
+            let bin = cycles * size as f64;
+            let lowest = (bin - LOBE_BINS as f64).ceil();
+            let offset = (lowest - (bin - LOBE_BINS as f64)) * LOBE_STEPS as f64;
+            let row = (offset as usize).min(LOBE_STEPS - 1);
+            let frac = (offset - row as f64) as f32;
+
+            let mut weights = [0.0; LOBE_WIDTH];
+            let lower = &self.lobe[row * LOBE_WIDTH..(row + 1) * LOBE_WIDTH];
+            let upper = &self.lobe[(row + 1) * LOBE_WIDTH..(row + 2) * LOBE_WIDTH];
+            for ((w, &lo), &hi) in weights.iter_mut().zip(lower).zip(upper) {
+                *w = lo + (hi - lo) * frac;
+            }
+
+            // The lobe may wrap around either end of the spectrum
+            let start = (lowest as i64).rem_euclid(size as i64) as usize;
+            let split = (size - start).min(LOBE_WIDTH);
+            for (range, weights) in [
+                (start..start + split, &weights[..split]),
+                (0..LOBE_WIDTH - split, &weights[split..]),
+            ] {
+                for ((re, im), &w) in self.re[range.clone()]
+                    .iter_mut()
+                    .zip(&mut self.im[range])
+                    .zip(weights)
+                {
+                    *re += a_re * w;
+                    *im += a_im * w;
+                }
+            }
+        }
+
+        self.fft.run(&mut self.re, &mut self.im);
+
+        // The frame is centred on index 0, so its first half sits at the end of the output
+        let (second, first) = self.re.split_at(self.hop);
+        for ((ready, tail), &sample) in self.ready.iter_mut().zip(&self.tail).zip(first) {
+            *ready = tail + sample;
+        }
+        self.tail.copy_from_slice(second);
+        self.consumed = 0;
+        self.next_center += hop;
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_inverse_fft_matches_direct_transform() {
+        let size = 64;
+        let fft = InverseFft::new(size);
+        let re: Vec<f32> = (0..size).map(|k| ((k * 7) % 5) as f32 - 2.0).collect();
+        let im: Vec<f32> = (0..size).map(|k| ((k * 3) % 7) as f32 - 3.0).collect();
+
+        let (mut out_re, mut out_im) = (re.clone(), im.clone());
+        fft.run(&mut out_re, &mut out_im);
+
+        for t in 0..size {
+            let (mut sum_re, mut sum_im) = (0.0, 0.0);
+            for k in 0..size {
+                let angle = 2.0 * PI * (k * t) as f64 / size as f64;
+                let (c, s) = (angle.cos(), angle.sin());
+                sum_re += re[k] as f64 * c - im[k] as f64 * s;
+                sum_im += re[k] as f64 * s + im[k] as f64 * c;
+            }
+            assert!((out_re[t] as f64 - sum_re).abs() < 1e-3);
+            assert!((out_im[t] as f64 - sum_im).abs() < 1e-3);
+        }
+    }
+
+    #[test]
+    fn test_bank_matches_windowed_envelope() {
+        let sample_rate = 8000.0;
+        let carriers = vec![
+            Carrier {
+                freq_hz: 612.3,
+                level: 0.5,
+                keyed: vec![(100, 900), (1200, 1500)],
+            },
+            Carrier {
+                freq_hz: 1777.7,
+                level: 0.25,
+                keyed: vec![(0, 2000)],
+            },
+        ];
+
+        // Expected: each carrier times its keyed fractions, interpolated by the Hann windows
+        let mut bank = SpectralBank::new(carriers, sample_rate, 5.0);
+        let hop = bank.hop as u64;
+        let expected: Vec<f32> = (0..2500u64)
+            .map(|t| {
+                let mut cursors = [0, 0];
+                bank.carriers
+                    .iter()
+                    .zip(&mut cursors)
+                    .map(|(carrier, next)| {
+                        let envelope: f64 = (t / hop..=t / hop + 1)
+                            .map(|m| {
+                                let center = m * hop;
+                                let from = center.saturating_sub(hop / 2);
+                                let keyed = carrier.keyed_in(next, from, center + hop / 2);
+                                let u = t as f64 - center as f64;
+                                let window = 0.5 + 0.5 * (PI * u / hop as f64).cos();
+                                window * keyed as f64 / hop as f64
+                            })
+                            .sum();
+                        let phase = 2.0 * PI * carrier.freq_hz as f64 / 8000.0 * t as f64;
+                        carrier.level as f64 * envelope * phase.cos()
+                    })
+                    .sum::<f64>() as f32
+            })
+            .collect();
+
+        let mut rendered = vec![0.0; expected.len()];
+        for chunk in rendered.chunks_mut(77) {
+            bank.render(chunk);
+        }
+
+        let error = rendered
+            .iter()
+            .zip(&expected)
+            .fold(0.0f32, |m, (a, b)| m.max((a - b).abs()));
+        assert!(error < 1e-3, "error {error}");
+    }
+}
@@ -1,5 +1,12 @@
-use crate::patterns::get_morse_pattern;
-use crate::types::{MorseElement, MorseElementType, MorseTimingParams};
+use crate::audio::{element_samples, WhiteNoise};
+use crate::patterns::{get_morse_pattern_code, get_morse_pattern_size, MorsePatternCode};
+use crate::types::{
+    MorseAudioParams, MorseElement, MorseElementType, MorseSize, MorseSymbol, MorseTimingParams,
+    MorseTimingPatch,
+};
+use std::ops::Range;
+use std::str::Bytes;
+#[cfg(not(target_arch = "wasm32"))]
 use std::time::{SystemTime, UNIX_EPOCH};
 
 // ITU timing constants
@@ -9,211 +16,1333 @@ const DOTS_PER_CHAR_GAP: i32 = 3; // ITU specification: inter-character gap = 3
 const DOTS_PER_WORD_GAP: i32 = 7; // ITU specification: inter-word gap = 7 dot durations
 const HUMANIZATION_MAX_VARIANCE: f32 = 0.3; // Maximum timing variation as fraction of base duration
 
-// Simple PRNG state for humanization - we need deterministic randomness
-struct SimpleRng {
-    state: u32,
-}
-
-impl SimpleRng {
-    fn new(seed: u32) -> Self {
-        // Use current time if seed is 0, with fallback for WASM
-        let actual_seed = if seed == 0 {
-            // Try to use system time, fallback to fixed seed for WASM
-            SystemTime::now()
-                .duration_since(UNIX_EPOCH)
-                .map(|d| d.as_secs() as u32)
-                .unwrap_or(12345) // Fixed fallback seed for WASM
-        } else {
-            seed
-        };
+const HUMANIZATION_SEED: u32 = 0x68D1_3F07; // Keeps jitter apart from noise drawn from the same seed
+const FALLBACK_SEED: u32 = 12345; // Seed 0 where there is no clock
+
+// Seed 0 asks for a different humanization every run
+fn resolve_seed(seed: u32) -> u32 {
+    if seed != 0 {
+        return seed;
+    }
+
+    // wasm32-unknown-unknown has no clock, and SystemTime::now panics there
+    #[cfg(target_arch = "wasm32")]
+    return FALLBACK_SEED;
+
+    #[cfg(not(target_arch = "wasm32"))]
+    SystemTime::now()
+        .duration_since(UNIX_EPOCH)
+        .map(|d| d.as_secs() as u32)
+        .unwrap_or(FALLBACK_SEED)
+}
+
+/// Counter-based humanization: the jitter of element `index` is a hash of that index and the
+/// seed, so any element's duration can be computed without generating the ones before it, and
+/// a seed gives the same timing on every platform.
+#[derive(Clone, Copy)]
+pub(crate) struct Humanizer {
+    noise: WhiteNoise,
+    factor: f32,
+}
+
+impl Humanizer {
+    /// None without humanization, so unhumanized timing does no hashing
+    pub(crate) fn new(params: &MorseTimingParams) -> Option<Self> {
+        (params.humanization_factor > 0.0).then(|| Self {
+            noise: WhiteNoise::new(resolve_seed(params.random_seed) ^ HUMANIZATION_SEED),
+            factor: params.humanization_factor,
+        })
+    }
+
+    /// Duration of element `index`, varied by up to ±(factor * HUMANIZATION_MAX_VARIANCE) of
+    /// its base duration, with bounded output
+    pub(crate) fn apply(&self, base_duration: f32, index: u64) -> f32 {
+        let draw = (self.noise.bits(index) >> 8) as f32 / 16_777_216.0; // [0, 1)
+        let max_variation = base_duration * self.factor * HUMANIZATION_MAX_VARIANCE;
+        let result = base_duration + (draw - 0.5) * 2.0 * max_variation;
+
+        // Clamp result to safe bounds: [10% of base, base * (1 + max_variance)]
+        let min_duration = base_duration * 0.1;
+        let max_duration = base_duration * (1.0 + HUMANIZATION_MAX_VARIANCE);
+
+        result.clamp(min_duration, max_duration)
+    }
+}
+
+/// Lazy source of the symbols of a text, read a byte at a time.
+///
+/// This is where the character, prosign and gap rules live; `MorseTimingIter` only gives the
+/// symbols their durations. Symbols don't depend on speed, so they can be produced once and
+/// re-timed at any WPM.
+pub struct MorseSymbolIter<I> {
+    bytes: I,
+    pattern: MorsePatternCode, // Elements of the character being sent still to come
+    element_gap_due: bool,     // An inter-element gap comes before the next of them
+    state: SymbolState,
+}
+
+// What the gap rules remember from one character to the next
+#[derive(Clone, Copy, PartialEq, Eq)]
+struct SymbolState {
+    after_mark: bool,      // Last symbol was a dot or dash
+    in_prosign: bool,      // Inside [...]
+    prosign_started: bool, // The prosign has had a character
+}
+
+impl SymbolState {
+    const START: Self = Self {
+        after_mark: false,
+        in_prosign: false,
+        prosign_started: false,
+    };
+
+    // The gap rules, for every reader of text: move past `ch`, returning the gap sent before
+    // it and the pattern it sends.
+    const fn step(&mut self, ch: u8) -> (Option<MorseSymbol>, Option<MorsePatternCode>) {
+        let pattern = get_morse_pattern_code(ch);
+
+        // Inside brackets: a prosign's characters run together with 1-dot gaps, and spaces and
+        // invalid characters are skipped
+        if self.in_prosign {
+            if ch == b']' {
+                self.in_prosign = false;
+                self.prosign_started = false;
+                return (None, None);
+            }
+            if pattern.is_none() {
+                return (None, None);
+            }
+            let gap = if self.prosign_started {
+                Some(MorseSymbol::ElementGap)
+            } else {
+                None
+            };
+            self.prosign_started = true;
+            self.after_mark = true;
+            return (gap, pattern);
+        }
+
+        match ch {
+            // Spaces are inter-word gaps
+            b' ' => {
+                self.after_mark = false;
+                (Some(MorseSymbol::WordGap), None)
+            }
+            b'[' => {
+                self.in_prosign = true;
+                (None, None)
+            }
+            _ if pattern.is_none() => (None, None),
+            // Inter-character gap, unless first or right after another gap
+            _ => {
+                let gap = if self.after_mark {
+                    Some(MorseSymbol::CharGap)
+                } else {
+                    None
+                };
+                self.after_mark = true;
+                (gap, pattern)
+            }
+        }
+    }
+}
+
+impl<'a> MorseSymbolIter<Bytes<'a>> {
+    /// Iterate over the symbols of `text`
+    pub fn new(text: &'a str) -> Self {
+        Self::from_bytes(text.bytes())
+    }
+}
+
+impl<I: Iterator<Item = u8>> MorseSymbolIter<I> {
+    /// Iterate over the symbols of any source of text bytes
+    pub fn from_bytes<J>(bytes: J) -> Self
+    where
+        J: IntoIterator<IntoIter = I>,
+    {
         Self {
-            state: actual_seed.wrapping_add(1), // Ensure non-zero
+            bytes: bytes.into_iter(),
+            pattern: MorsePatternCode::EMPTY,
+            element_gap_due: false,
+            state: SymbolState::START,
         }
     }
 
-    fn next_f32(&mut self) -> f32 {
-        // Simple LCG (Linear Congruential Generator) - matches C rand() behavior roughly
-        self.state = self.state.wrapping_mul(1103515245).wrapping_add(12345);
-        // Normalize to [0, 1)
-        (self.state >> 16) as f32 / 65536.0
+    // Continue from `state`, left between the characters of another iterator
+    fn resume(bytes: I, state: SymbolState) -> Self {
+        Self {
+            state,
+            ..Self::from_bytes(bytes)
+        }
+    }
+
+    // Next element of the character being sent, with the gaps between its elements
+    fn next_in_pattern(&mut self) -> Option<MorseSymbol> {
+        let (element_type, rest) = self.pattern.split_first()?;
+
+        if self.element_gap_due {
+            self.element_gap_due = false;
+            return Some(MorseSymbol::ElementGap);
+        }
+
+        self.pattern = rest;
+        self.element_gap_due = !rest.is_empty();
+        Some(match element_type {
+            MorseElementType::Dash => MorseSymbol::Dash,
+            _ => MorseSymbol::Dot,
+        })
+    }
+
+    fn start_pattern(&mut self, pattern: MorsePatternCode) {
+        self.pattern = pattern;
+        self.element_gap_due = false;
+    }
+}
+
+impl<I: Iterator<Item = u8>> Iterator for MorseSymbolIter<I> {
+    type Item = MorseSymbol;
+
+    fn next(&mut self) -> Option<MorseSymbol> {
+        loop {
+            if let Some(symbol) = self.next_in_pattern() {
+                return Some(symbol);
+            }
+
+            let (gap, pattern) = self.state.step(self.bytes.next()?);
+            if let Some(pattern) = pattern {
+                self.start_pattern(pattern);
+            }
+            if gap.is_some() {
+                return gap;
+            }
+        }
     }
 }
 
-// Apply humanization - adds random variation to timing with bounded output
-fn apply_humanization(
-    base_duration: f32,
-    humanization_factor: f32,
-    rng: &mut Option<SimpleRng>,
-) -> f32 {
-    if humanization_factor <= 0.0 {
-        return base_duration;
+/// Generate the symbols of a text, for timing later at any speed
+pub fn morse_symbols(text: &str) -> Vec<MorseSymbol> {
+    MorseSymbolIter::new(text).collect()
+}
+
+// Duration of each symbol, indexed by its byte value. The ITU expressions are evaluated once
+// here, so every consumer truncates them identically.
+const fn symbol_durations(wpm: i32, word_gap_multiplier: f32) -> [f32; 5] {
+    let dot_sec = DOT_LENGTH_WPM / wpm as f32;
+    [
+        dot_sec,
+        dot_sec * DOTS_PER_DASH as f32,
+        dot_sec,
+        dot_sec * DOTS_PER_CHAR_GAP as f32,
+        dot_sec * DOTS_PER_WORD_GAP as f32 * word_gap_multiplier,
+    ]
+}
+
+// `MorseSymbolIter` as a const fn, for encoding literals at compile time.
+// Writes as many symbols of `text` as fit in `out` and returns how many there are in all.
+const fn encode_symbols(text: &[u8], out: &mut [MorseSymbol]) -> usize {
+    const fn push(out: &mut [MorseSymbol], count: usize, symbol: MorseSymbol) -> usize {
+        if count < out.len() {
+            out[count] = symbol;
+        }
+        count + 1
+    }
+
+    const fn push_pattern(
+        out: &mut [MorseSymbol],
+        mut count: usize,
+        mut pattern: MorsePatternCode,
+    ) -> usize {
+        let mut first = true;
+        while let Some((element_type, rest)) = pattern.split_first() {
+            if !first {
+                count = push(out, count, MorseSymbol::ElementGap);
+            }
+            let symbol = match element_type {
+                MorseElementType::Dash => MorseSymbol::Dash,
+                _ => MorseSymbol::Dot,
+            };
+            count = push(out, count, symbol);
+            (pattern, first) = (rest, false);
+        }
+        count
     }
 
-    let variation = if let Some(rng) = rng {
-        // Generate random variation: ±(humanization_factor * HUMANIZATION_MAX_VARIANCE) of base duration
-        let max_variation = base_duration * humanization_factor * HUMANIZATION_MAX_VARIANCE;
-        (rng.next_f32() - 0.5) * 2.0 * max_variation
-    } else {
-        0.0
+    let mut count = 0;
+    let mut state = SymbolState::START;
+    let mut i = 0;
+
+    while i < text.len() {
+        let (gap, pattern) = state.step(text[i]);
+        i += 1;
+
+        if let Some(gap) = gap {
+            count = push(out, count, gap);
+        }
+        if let Some(pattern) = pattern {
+            count = push_pattern(out, count, pattern);
+        }
+    }
+
+    count
+}
+
+/// Number of symbols in `text`; the array length for `morse_symbols_array`
+pub const fn morse_symbol_count(text: &str) -> usize {
+    encode_symbols(text.as_bytes(), &mut [])
+}
+
+/// The symbols of `text` as an array of exactly `morse_symbol_count(text)` entries. In a
+/// const item this runs at compile time; `morse_symbols!` sizes and stores it in one step.
+pub const fn morse_symbols_array<const N: usize>(text: &str) -> [MorseSymbol; N] {
+    let mut symbols = [MorseSymbol::Dot; N];
+    let count = encode_symbols(text.as_bytes(), &mut symbols);
+    assert!(
+        count == N,
+        "Array length is not the symbol count of the text"
+    );
+    symbols
+}
+
+/// The unhumanized timing of `text` as an array of exactly `morse_symbol_count(text)`
+/// elements, identical to `morse_timing`. In a const item this runs at compile time;
+/// `morse_elements!` sizes and stores it in one step.
+pub const fn morse_elements_array<const N: usize>(
+    text: &str,
+    wpm: i32,
+    word_gap_multiplier: f32,
+) -> [MorseElement; N] {
+    assert!(wpm > 0, "Invalid WPM");
+    let symbols: [MorseSymbol; N] = morse_symbols_array(text);
+    let durations = symbol_durations(wpm, word_gap_multiplier);
+
+    let mut elements = [MorseElement {
+        element_type: MorseElementType::Gap,
+        duration_seconds: 0.0,
+    }; N];
+    let mut i = 0;
+    while i < N {
+        elements[i] = MorseElement {
+            element_type: symbols[i].element_type(),
+            duration_seconds: durations[symbols[i] as usize],
+        };
+        i += 1;
+    }
+    elements
+}
+
+/// Symbols of a string literal, encoded at compile time, as a `&'static [MorseSymbol]`
+#[macro_export]
+macro_rules! morse_symbols {
+    ($text:expr) => {{
+        const SYMBOLS: [$crate::MorseSymbol; $crate::timing::morse_symbol_count($text)] =
+            $crate::timing::morse_symbols_array($text);
+        &SYMBOLS as &'static [$crate::MorseSymbol]
+    }};
+}
+
+/// Unhumanized timing of a string literal at a fixed speed and optional word gap multiplier,
+/// computed at compile time, as a `&'static [MorseElement]`
+#[macro_export]
+macro_rules! morse_elements {
+    ($text:expr, $wpm:expr) => {
+        $crate::morse_elements!($text, $wpm, 1.0)
     };
+    ($text:expr, $wpm:expr, $word_gap_multiplier:expr) => {{
+        const ELEMENTS: [$crate::MorseElement; $crate::timing::morse_symbol_count($text)] =
+            $crate::timing::morse_elements_array($text, $wpm, $word_gap_multiplier);
+        &ELEMENTS as &'static [$crate::MorseElement]
+    }};
+}
+
+/// Lazy source of timing elements, read from text a byte at a time.
+///
+/// Applies exactly the character, prosign and gap rules of `morse_timing`, and humanizes element
+/// k from its index alone, so collecting it gives the same elements. Memory use is constant
+/// however long the input, so text from a file or stdin can feed `MorseAudioStream` directly.
+/// `from_symbols` times symbols produced earlier by `morse_symbols`.
+pub struct MorseTimingIter<S> {
+    symbols: S,
+    durations: [f32; 5],
+    humanizer: Option<Humanizer>,
+    index: u64, // Of the next element
+}
+
+impl<'a> MorseTimingIter<MorseSymbolIter<Bytes<'a>>> {
+    /// Iterate over the timing elements of `text`
+    pub fn new(text: &'a str, params: &MorseTimingParams) -> Result<Self, String> {
+        Self::from_symbols(MorseSymbolIter::new(text), params)
+    }
+}
+
+impl<I: Iterator<Item = u8>> MorseTimingIter<MorseSymbolIter<I>> {
+    /// Iterate over the timing elements of any source of text bytes
+    pub fn from_bytes<J>(bytes: J, params: &MorseTimingParams) -> Result<Self, String>
+    where
+        J: IntoIterator<IntoIter = I>,
+    {
+        Self::from_symbols(MorseSymbolIter::from_bytes(bytes), params)
+    }
+}
+
+impl<S: Iterator<Item = MorseSymbol>> MorseTimingIter<S> {
+    /// Iterate over the timing elements of a sequence of symbols
+    pub fn from_symbols<T>(symbols: T, params: &MorseTimingParams) -> Result<Self, String>
+    where
+        T: IntoIterator<IntoIter = S>,
+    {
+        if params.wpm <= 0 {
+            return Err("Invalid WPM".to_string());
+        }
+
+        Ok(Self {
+            symbols: symbols.into_iter(),
+            durations: symbol_durations(params.wpm, params.word_gap_multiplier),
+            humanizer: Humanizer::new(params),
+            index: 0,
+        })
+    }
+}
+
+impl<S> MorseTimingIter<S> {
+    fn element(&mut self, symbol: MorseSymbol) -> MorseElement {
+        let base_duration = self.durations[symbol as usize];
+        let index = self.index;
+        self.index += 1;
+        MorseElement {
+            element_type: symbol.element_type(),
+            duration_seconds: match &self.humanizer {
+                Some(humanizer) => humanizer.apply(base_duration, index),
+                None => base_duration,
+            },
+        }
+    }
 
-    let result = base_duration + variation;
+    // A fresh iterator over `text` with the same durations and humanization seed
+    fn restart<'a>(&self, text: &'a str) -> MorseTimingIter<MorseSymbolIter<Bytes<'a>>> {
+        MorseTimingIter {
+            symbols: MorseSymbolIter::new(text),
+            durations: self.durations,
+            humanizer: self.humanizer,
+            index: 0,
+        }
+    }
+}
 
-    // Clamp result to safe bounds: [10% of base, base * (1 + max_variance)]
-    let min_duration = base_duration * 0.1;
-    let max_duration = base_duration * (1.0 + HUMANIZATION_MAX_VARIANCE);
+impl<S: Iterator<Item = MorseSymbol>> Iterator for MorseTimingIter<S> {
+    type Item = MorseElement;
+
+    fn next(&mut self) -> Option<MorseElement> {
+        let symbol = self.symbols.next()?;
+        Some(self.element(symbol))
+    }
 
-    result.clamp(min_duration, max_duration)
+    // Skipped elements need no jitter, as no later draw depends on them
+    fn nth(&mut self, n: usize) -> Option<MorseElement> {
+        let symbol = self.symbols.nth(n)?;
+        self.index += n as u64;
+        Some(self.element(symbol))
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        self.symbols.size_hint()
+    }
 }
 
 /// Generate morse code timing elements from text
-/// Returns the actual number of elements generated
 pub fn morse_timing(text: &str, params: &MorseTimingParams) -> Result<Vec<MorseElement>, String> {
-    if params.wpm <= 0 {
-        return Err("Invalid WPM".to_string());
+    Ok(MorseTimingIter::new(text, params)?.collect())
+}
+
+/// Time symbols from `morse_symbols`; equal to `morse_timing` of the text they came from
+pub fn morse_timing_from_symbols(
+    symbols: &[MorseSymbol],
+    params: &MorseTimingParams,
+) -> Result<Vec<MorseElement>, String> {
+    Ok(MorseTimingIter::from_symbols(symbols.iter().copied(), params)?.collect())
+}
+
+// Timing state before a byte of a `MorseTimingSession` text
+#[derive(Clone, Copy)]
+struct Checkpoint {
+    element: usize, // Index of the byte's first element
+    seconds: f64,   // Start time of that element
+    state: SymbolState,
+}
+
+/// Timing of a text that is edited in place, such as the contents of a text box.
+///
+/// A checkpoint before every byte holds the element offset, start time and gap rule state
+/// there, so an edit re-times from the first changed byte rather than from the start. Past the
+/// edit, re-timing stops as soon as the state matches the old checkpoint again, and the old
+/// elements are kept from there: humanization is counter-based, so this needs the same
+/// element offset as well when it is on, and a humanized edit that changes the element count
+/// re-times the rest of the text. The elements always equal `morse_timing` of the text.
+pub struct MorseTimingSession {
+    text: String,
+    elements: Vec<MorseElement>,
+    checkpoints: Vec<Checkpoint>, // One per byte, and one for the end
+    durations: [f32; 5],
+    humanizer: Option<Humanizer>,
+}
+
+impl MorseTimingSession {
+    /// Time `text` and keep its checkpoints
+    pub fn new(text: &str, params: &MorseTimingParams) -> Result<Self, String> {
+        // Durations and humanization seed are fixed once, so a seed of 0 stays put across edits
+        let template = MorseTimingIter::from_symbols(std::iter::empty(), params)?;
+        let mut session = Self {
+            text: String::new(),
+            elements: Vec::new(),
+            checkpoints: vec![Checkpoint {
+                element: 0,
+                seconds: 0.0,
+                state: SymbolState::START,
+            }],
+            durations: template.durations,
+            humanizer: template.humanizer,
+        };
+        session.edit(0..0, text)?;
+        Ok(session)
     }
 
-    let mut rng = if params.humanization_factor > 0.0 {
-        Some(SimpleRng::new(params.random_seed))
-    } else {
-        None
-    };
+    /// The current text
+    pub fn text(&self) -> &str {
+        &self.text
+    }
 
-    let dot_sec = DOT_LENGTH_WPM / params.wpm as f32;
-    let mut elements = Vec::new();
-    let mut chars = text.bytes().peekable();
+    /// The timing elements of the current text
+    pub fn elements(&self) -> &[MorseElement] {
+        &self.elements
+    }
 
-    while let Some(ch) = chars.next() {
-        // Handle spaces as inter-word gaps
-        if ch == b' ' {
-            let word_gap_duration = dot_sec * DOTS_PER_WORD_GAP as f32 * params.word_gap_multiplier;
-            let duration =
-                apply_humanization(word_gap_duration, params.humanization_factor, &mut rng);
+    /// Total duration of the current text
+    pub fn duration_seconds(&self) -> f64 {
+        self.checkpoints[self.text.len()].seconds
+    }
 
-            elements.push(MorseElement {
-                element_type: MorseElementType::Gap,
-                duration_seconds: duration,
-            });
-            continue;
+    /// Replace the whole text, re-timing only between the first and last changed bytes
+    pub fn set_text(&mut self, text: &str) -> MorseTimingPatch {
+        let (old, new) = (self.text.as_bytes(), text.as_bytes());
+        let mut prefix = old.iter().zip(new).take_while(|(a, b)| a == b).count();
+        while !text.is_char_boundary(prefix) {
+            prefix -= 1;
+        }
+        let mut suffix = old[prefix..]
+            .iter()
+            .rev()
+            .zip(new[prefix..].iter().rev())
+            .take_while(|(a, b)| a == b)
+            .count();
+        while !text.is_char_boundary(text.len() - suffix) {
+            suffix -= 1;
         }
 
-        // Handle prosigns in brackets [...]
-        if ch == b'[' {
-            let mut prosign_char_count = 0;
-
-            // Process characters inside brackets (skip spaces and invalid chars)
-            while let Some(&prosign_ch) = chars.peek() {
-                if prosign_ch == b']' {
-                    chars.next(); // consume the closing bracket
-                    break;
-                }
+        let range = prefix..old.len() - suffix;
+        self.edit(range, &text[prefix..text.len() - suffix])
+            .expect("edit range lies on character boundaries")
+    }
 
-                let prosign_ch = chars.next().unwrap();
+    /// Replace the bytes `range` of the text with `replacement`, returning the elements that
+    /// changed
+    pub fn edit(
+        &mut self,
+        range: Range<usize>,
+        replacement: &str,
+    ) -> Result<MorseTimingPatch, String> {
+        let Range { start, end } = range;
+        if start > end
+            || end > self.text.len()
+            || !self.text.is_char_boundary(start)
+            || !self.text.is_char_boundary(end)
+        {
+            return Err("Invalid edit range".to_string());
+        }
 
-                // Skip spaces inside prosigns
-                if prosign_ch == b' ' {
-                    continue;
-                }
+        let from = self.checkpoints[start];
+        let mut at = from;
+        let mut elements = Vec::new();
+        let mut checkpoints = Vec::with_capacity(replacement.len() + 1);
 
-                if let Some(pattern) = get_morse_pattern(prosign_ch) {
-                    // Add 1-dot gap between characters in prosign (except for first character)
-                    if prosign_char_count > 0 {
-                        let duration =
-                            apply_humanization(dot_sec, params.humanization_factor, &mut rng);
-                        elements.push(MorseElement {
-                            element_type: MorseElementType::Gap,
-                            duration_seconds: duration,
-                        });
-                    }
-
-                    // Add pattern elements
-                    for (i, &element_type) in pattern.iter().enumerate() {
-                        let base_duration = match element_type {
-                            MorseElementType::Dot => dot_sec,
-                            MorseElementType::Dash => dot_sec * DOTS_PER_DASH as f32,
-                            MorseElementType::Gap => dot_sec, // shouldn't happen in patterns
-                        };
-                        let duration =
-                            apply_humanization(base_duration, params.humanization_factor, &mut rng);
-
-                        elements.push(MorseElement {
-                            element_type,
-                            duration_seconds: duration,
-                        });
-
-                        // Add inter-element gap (except after last element)
-                        if i < pattern.len() - 1 {
-                            let gap_duration =
-                                apply_humanization(dot_sec, params.humanization_factor, &mut rng);
-                            elements.push(MorseElement {
-                                element_type: MorseElementType::Gap,
-                                duration_seconds: gap_duration,
-                            });
-                        }
-                    }
-                    prosign_char_count += 1;
+        // The replacement, then the old text after it until the state is back in step
+        let mut resync = None;
+        let suffix = self.text.as_bytes()[end..].iter().enumerate();
+        let bytes = replacement.bytes().map(|byte| (None, byte));
+        for (old, byte) in bytes.chain(suffix.map(|(k, &byte)| (Some(end + k), byte))) {
+            if let Some(old) = old {
+                let checkpoint = self.checkpoints[old];
+                if at.state == checkpoint.state
+                    && (self.humanizer.is_none() || at.element == checkpoint.element)
+                {
+                    resync = Some(old);
+                    break;
                 }
             }
-        } else {
-            // Handle regular character
-            if let Some(pattern) = get_morse_pattern(ch) {
-                // Add inter-character gap if not the first character
-                if !elements.is_empty() {
-                    // Check if last element was not already a gap to avoid duplicate gaps
-                    let should_add_gap = elements
-                        .last()
-                        .map(|e| e.element_type != MorseElementType::Gap)
-                        .unwrap_or(true);
-
-                    if should_add_gap {
-                        let inter_char_duration = dot_sec * DOTS_PER_CHAR_GAP as f32;
-                        let duration = apply_humanization(
-                            inter_char_duration,
-                            params.humanization_factor,
-                            &mut rng,
-                        );
-                        elements.push(MorseElement {
-                            element_type: MorseElementType::Gap,
-                            duration_seconds: duration,
-                        });
-                    }
-                }
+            checkpoints.push(at);
+            at = self.step(byte, at, &mut elements);
+        }
 
-                // Add pattern elements
-                for (i, &element_type) in pattern.iter().enumerate() {
-                    let base_duration = match element_type {
-                        MorseElementType::Dot => dot_sec,
-                        MorseElementType::Dash => dot_sec * DOTS_PER_DASH as f32,
-                        MorseElementType::Gap => dot_sec, // shouldn't happen in patterns
-                    };
-                    let duration =
-                        apply_humanization(base_duration, params.humanization_factor, &mut rng);
-
-                    elements.push(MorseElement {
-                        element_type,
-                        duration_seconds: duration,
-                    });
-
-                    // Add inter-element gap (except after last element)
-                    if i < pattern.len() - 1 {
-                        let gap_duration =
-                            apply_humanization(dot_sec, params.humanization_factor, &mut rng);
-                        elements.push(MorseElement {
-                            element_type: MorseElementType::Gap,
-                            duration_seconds: gap_duration,
-                        });
-                    }
+        // Old elements and checkpoints after the resync point stay, moved by the change
+        let (old_byte, old_element) = match resync {
+            Some(old_byte) => {
+                let old = self.checkpoints[old_byte];
+                let shift = at.element as isize - old.element as isize;
+                let delay = at.seconds - old.seconds;
+                for checkpoint in &mut self.checkpoints[old_byte..] {
+                    checkpoint.element = checkpoint.element.wrapping_add_signed(shift);
+                    checkpoint.seconds += delay;
                 }
+                (old_byte, old.element)
+            }
+            None => {
+                checkpoints.push(at);
+                (self.checkpoints.len(), self.elements.len())
             }
+        };
+
+        let patch = MorseTimingPatch {
+            start: from.element,
+            removed: old_element - from.element,
+            inserted: elements.len(),
+            start_seconds: from.seconds,
+        };
+        self.elements.splice(from.element..old_element, elements);
+        self.checkpoints.splice(start..old_byte, checkpoints);
+        self.text.replace_range(start..end, replacement);
+        Ok(patch)
+    }
+
+    // Time one byte from checkpoint `at`, appending its elements, and return the checkpoint
+    // after it
+    fn step(&self, byte: u8, at: Checkpoint, out: &mut Vec<MorseElement>) -> Checkpoint {
+        let first = out.len();
+        let mut symbols = MorseSymbolIter::resume(std::iter::once(byte), at.state);
+        out.extend(MorseTimingIter {
+            symbols: &mut symbols,
+            durations: self.durations,
+            humanizer: self.humanizer,
+            index: at.element as u64,
+        });
+
+        Checkpoint {
+            element: at.element + out.len() - first,
+            seconds: out[first..]
+                .iter()
+                .fold(at.seconds, |seconds, e| seconds + e.duration_seconds as f64),
+            state: symbols.state,
         }
     }
+}
+
+#[cfg(feature = "parallel")]
+const PARALLEL_MIN_CHUNK: usize = 64 * 1024; // Bytes of text per task
+#[cfg(feature = "parallel")]
+const PARALLEL_CHUNKS_PER_THREAD: usize = 4;
+#[cfg(feature = "parallel")]
+const PARALLEL_MIN_BATCH: usize = 256; // Texts per task
+
+/// Generate morse code timing elements from text using all available cores.
+///
+/// The text is cut after word gaps, where the gap rules start afresh, so every chunk times
+/// independently. Chunk element counts come from one counting pass each, and their prefix sums
+/// give each chunk its place in the output and the index of its first humanization draw. The result is identical to `morse_timing`.
+#[cfg(feature = "parallel")]
+pub fn morse_timing_parallel(
+    text: &str,
+    params: &MorseTimingParams,
+) -> Result<Vec<MorseElement>, String> {
+    let threads = crate::parallel::thread_count();
+    let chunk_bytes = (text.len() / (threads * PARALLEL_CHUNKS_PER_THREAD)).max(PARALLEL_MIN_CHUNK);
+    if threads == 1 || text.len() <= chunk_bytes {
+        return morse_timing(text, params);
+    }
+
+    timing_chunks(text, params, chunk_bytes)
+}
+
+// Time `text` as pieces of at least `chunk_bytes` bytes, rendered in parallel
+#[cfg(feature = "parallel")]
+fn timing_chunks(
+    text: &str,
+    params: &MorseTimingParams,
+    chunk_bytes: usize,
+) -> Result<Vec<MorseElement>, String> {
+    // Durations and humanization seed are fixed once, so a seed of 0 can't differ by chunk
+    let template = MorseTimingIter::from_symbols(std::iter::empty(), params)?;
+
+    // Cut just after word gaps, which only come outside prosigns and leave the gap rules in
+    // their starting state
+    let mut chunks = Vec::new();
+    let mut chunk_start = 0;
+    let mut state = SymbolState::START;
+    for (i, &ch) in text.as_bytes().iter().enumerate() {
+        let (gap, _) = state.step(ch);
+        if gap == Some(MorseSymbol::WordGap) && i + 1 - chunk_start >= chunk_bytes {
+            debug_assert!(state == SymbolState::START);
+            chunks.push(&text[chunk_start..=i]);
+            chunk_start = i + 1;
+        }
+    }
+    chunks.push(&text[chunk_start..]);
+
+    let mut counts = vec![0; chunks.len()];
+    let tasks = chunks.iter().zip(counts.iter_mut()).collect();
+    crate::parallel::run_parallel(tasks, |(chunk, count)| {
+        *count = ElementCounts::of(chunk).total();
+    });
+
+    let placeholder = MorseElement {
+        element_type: MorseElementType::Gap,
+        duration_seconds: 0.0,
+    };
+    let mut elements = vec![placeholder; counts.iter().sum()];
+    let mut tasks = Vec::with_capacity(chunks.len());
+    let (mut rest, mut index) = (&mut elements[..], 0);
+    for (chunk, &count) in chunks.iter().zip(&counts) {
+        let (out, tail) = rest.split_at_mut(count);
+        tasks.push((chunk, index, out));
+        rest = tail;
+        index += count as u64;
+    }
+
+    crate::parallel::run_parallel(tasks, |(chunk, index, out)| {
+        let elements = MorseTimingIter {
+            index,
+            ..template.restart(chunk)
+        };
+        for (out, element) in out.iter_mut().zip(elements) {
+            *out = element;
+        }
+    });
 
     Ok(elements)
 }
 
-/// Calculate size needed for timing elements (without actually generating them)
+/// Timing elements of many texts in one contiguous buffer, with an offsets table giving each
+/// text's run (a CSR layout).
+///
+/// `time` sizes the whole batch with one counting pass before writing it, so a batch costs at
+/// most one allocation per buffer, and none once a reused batch has grown to its working size.
+/// Text `i` gets exactly the elements of `morse_timing` on it.
+#[derive(Debug, Clone)]
+pub struct MorseTimingBatch {
+    elements: Vec<MorseElement>,
+    offsets: Vec<usize>, // Text i's elements are elements[offsets[i]..offsets[i + 1]]
+}
+
+impl Default for MorseTimingBatch {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl MorseTimingBatch {
+    pub fn new() -> Self {
+        Self {
+            elements: Vec::new(),
+            offsets: vec![0],
+        }
+    }
+
+    /// Replace the contents with the timing of `texts`
+    pub fn time<T: AsRef<str>>(
+        &mut self,
+        texts: &[T],
+        params: &MorseTimingParams,
+    ) -> Result<(), String> {
+        let template = MorseTimingIter::from_symbols(std::iter::empty(), params)?;
+
+        self.offsets.clear();
+        self.offsets.push(0);
+        let mut total = 0;
+        for text in texts {
+            total += ElementCounts::of(text.as_ref()).total();
+            self.offsets.push(total);
+        }
+
+        self.elements.clear();
+        self.elements.reserve(total);
+        for text in texts {
+            self.elements.extend(template.restart(text.as_ref()));
+        }
+        Ok(())
+    }
+
+    /// Number of texts
+    pub fn len(&self) -> usize {
+        self.offsets.len() - 1
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Elements of text `index`
+    pub fn get(&self, index: usize) -> Option<&[MorseElement]> {
+        let range = self.offsets.get(index)?..self.offsets.get(index + 1)?;
+        Some(&self.elements[*range.start..*range.end])
+    }
+
+    /// Elements of every text, in order
+    pub fn iter(&self) -> impl Iterator<Item = &[MorseElement]> + '_ {
+        self.offsets
+            .windows(2)
+            .map(|run| &self.elements[run[0]..run[1]])
+    }
+
+    /// All elements, back to back
+    pub fn elements(&self) -> &[MorseElement] {
+        &self.elements
+    }
+
+    /// Start of each text's elements, followed by the total
+    pub fn offsets(&self) -> &[usize] {
+        &self.offsets
+    }
+}
+
+/// Generate the timing of many texts into one batch
+pub fn morse_timing_batch<T: AsRef<str>>(
+    texts: &[T],
+    params: &MorseTimingParams,
+) -> Result<MorseTimingBatch, String> {
+    let mut batch = MorseTimingBatch::new();
+    batch.time(texts, params)?;
+    Ok(batch)
+}
+
+/// Generate the timing of many texts into one batch using all available cores. Texts are
+/// counted and then timed in groups, each group writing to its own part of the buffer; the
+/// result is identical to `morse_timing_batch`.
+#[cfg(feature = "parallel")]
+pub fn morse_timing_batch_parallel<T: AsRef<str> + Sync>(
+    texts: &[T],
+    params: &MorseTimingParams,
+) -> Result<MorseTimingBatch, String> {
+    let template = MorseTimingIter::from_symbols(std::iter::empty(), params)?;
+    let threads = crate::parallel::thread_count();
+    let group = texts
+        .len()
+        .div_ceil(threads * PARALLEL_CHUNKS_PER_THREAD)
+        .max(PARALLEL_MIN_BATCH);
+
+    let mut offsets = vec![0; texts.len() + 1];
+    let tasks = texts
+        .chunks(group)
+        .zip(offsets[1..].chunks_mut(group))
+        .collect();
+    crate::parallel::run_parallel(tasks, |(texts, counts): (&[T], &mut [usize])| {
+        for (text, count) in texts.iter().zip(counts) {
+            *count = ElementCounts::of(text.as_ref()).total();
+        }
+    });
+    for i in 1..offsets.len() {
+        offsets[i] += offsets[i - 1];
+    }
+
+    let placeholder = MorseElement {
+        element_type: MorseElementType::Gap,
+        duration_seconds: 0.0,
+    };
+    let mut elements = vec![placeholder; offsets[texts.len()]];
+    let mut tasks = Vec::new();
+    let mut rest = &mut elements[..];
+    for (start, texts) in texts.chunks(group).enumerate() {
+        let start = start * group;
+        let (out, tail) = rest.split_at_mut(offsets[start + texts.len()] - offsets[start]);
+        tasks.push((texts, out));
+        rest = tail;
+    }
+    crate::parallel::run_parallel(tasks, |(texts, out)| {
+        let elements = texts
+            .iter()
+            .flat_map(|text| template.restart(text.as_ref()));
+        for (out, element) in out.iter_mut().zip(elements) {
+            *out = element;
+        }
+    });
+
+    Ok(MorseTimingBatch { elements, offsets })
+}
+
+// Elements of a text by duration: without humanization all elements of a class are equally
+// long. Dot-long elements are dots, the gaps inside characters and the gaps inside prosigns.
+#[derive(Default)]
+struct ElementCounts {
+    dot_long: usize,
+    dashes: usize,
+    char_gaps: usize,
+    word_gaps: usize,
+}
+
+impl ElementCounts {
+    // One pass over the bytes with the gap rules and the pattern size table
+    fn of(text: &str) -> Self {
+        let mut counts = Self::default();
+        let mut state = SymbolState::START;
+
+        for ch in text.bytes() {
+            let (gap, pattern) = state.step(ch);
+            match gap {
+                Some(MorseSymbol::WordGap) => counts.word_gaps += 1,
+                Some(MorseSymbol::CharGap) => counts.char_gaps += 1,
+                Some(_) => counts.dot_long += 1, // Between the characters of a prosign
+                None => {}
+            }
+            if let Some(size) = pattern.and(get_morse_pattern_size(ch)) {
+                counts.add_pattern(size.elements, size.dot_units);
+            }
+        }
+
+        counts
+    }
+
+    fn add_pattern(&mut self, elements: u8, dot_units: u8) {
+        // Every dash is two dot units longer than a dot-long element
+        let dashes = (dot_units - elements) as usize / 2;
+        self.dashes += dashes;
+        self.dot_long += elements as usize - dashes;
+    }
+
+    fn total(&self) -> usize {
+        self.dot_long + self.dashes + self.char_gaps + self.word_gaps
+    }
+}
+
+/// Calculate the number of timing elements for a text, without generating them
 pub fn morse_timing_size(text: &str, params: &MorseTimingParams) -> Result<usize, String> {
-    // For size calculation, we can just generate the actual elements and count them
-    // This is simpler than duplicating the complex logic, and performance impact is minimal
-    morse_timing(text, params).map(|elements| elements.len())
+    if params.wpm <= 0 {
+        return Err("Invalid WPM".to_string());
+    }
+    Ok(ElementCounts::of(text).total())
+}
+
+/// Calculate the exact element count, duration and sample count of a text's timing and audio,
+/// without allocating.
+///
+/// Without humanization every element of a kind has the same duration, so the result comes
+/// from counting elements by kind in one pass over the text. Humanized durations are random, so
+/// they are replayed through `MorseTimingIter` without being stored; with a random seed of 0
+/// that replay only matches a render started within the same second.
+pub fn morse_size(
+    text: &str,
+    timing_params: &MorseTimingParams,
+    audio_params: &MorseAudioParams,
+) -> Result<MorseSize, String> {
+    if timing_params.wpm <= 0 {
+        return Err("Invalid WPM".to_string());
+    }
+    if audio_params.sample_rate <= 0 {
+        return Err("Invalid sample rate".to_string());
+    }
+
+    let sample_rate = audio_params.sample_rate as f32;
+    let mut size = MorseSize {
+        elements: 0,
+        duration_seconds: 0.0,
+        samples: 0,
+    };
+
+    if timing_params.humanization_factor > 0.0 {
+        for element in MorseTimingIter::new(text, timing_params)? {
+            size.elements += 1;
+            size.duration_seconds += element.duration_seconds as f64;
+            size.samples += element_samples(element.duration_seconds, sample_rate);
+        }
+        return Ok(size);
+    }
+
+    // The same durations as the iterator, so each class truncates identically
+    let durations = symbol_durations(timing_params.wpm, timing_params.word_gap_multiplier);
+    let counts = ElementCounts::of(text);
+    let classes = [
+        (counts.dot_long, durations[MorseSymbol::Dot as usize]),
+        (counts.dashes, durations[MorseSymbol::Dash as usize]),
+        (counts.char_gaps, durations[MorseSymbol::CharGap as usize]),
+        (counts.word_gaps, durations[MorseSymbol::WordGap as usize]),
+    ];
+
+    for (count, duration) in classes {
+        size.elements += count;
+        size.duration_seconds += count as f64 * duration as f64;
+        size.samples += count * element_samples(duration, sample_rate);
+    }
+    Ok(size)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_timing_iter_follows_gap_rules() {
+        use MorseElementType::{Dash, Dot, Gap};
+
+        let params = MorseTimingParams::default();
+        let dot = DOT_LENGTH_WPM / params.wpm as f32;
+        let elements: Vec<_> = MorseTimingIter::new("E[A R]E ", &params)
+            .unwrap()
+            .map(|e| (e.element_type, (e.duration_seconds / dot).round() as i32))
+            .collect();
+
+        // No gap before a prosign, 1-dot gaps between its characters, a character gap after it
+        let expected = [
+            (Dot, 1),
+            (Dot, 1),
+            (Gap, 1),
+            (Dash, 3),
+            (Gap, 1),
+            (Dot, 1),
+            (Gap, 1),
+            (Dash, 3),
+            (Gap, 1),
+            (Dot, 1),
+            (Gap, 3),
+            (Dot, 1),
+            (Gap, 7),
+        ];
+        assert_eq!(elements, expected);
+    }
+
+    #[test]
+    fn test_timing_iter_streams_bytes() {
+        let params = MorseTimingParams {
+            humanization_factor: 0.5,
+            random_seed: 99,
+            ..Default::default()
+        };
+        let text = "CQ [SK] DE W1AW 73";
+
+        let key = |e: MorseElement| (e.element_type, e.duration_seconds.to_bits());
+        let collected: Vec<_> = morse_timing(text, &params)
+            .unwrap()
+            .into_iter()
+            .map(key)
+            .collect();
+        let streamed: Vec<_> =
+            MorseTimingIter::from_bytes(text.bytes().collect::<Vec<_>>(), &params)
+                .unwrap()
+                .map(key)
+                .collect();
+        assert_eq!(streamed, collected);
+        assert_eq!(morse_timing_size(text, &params).unwrap(), collected.len());
+    }
+
+    #[test]
+    fn test_size_matches_render() {
+        let audio_params = MorseAudioParams {
+            sample_rate: 44100,
+            ..Default::default()
+        };
+
+        for humanization_factor in [0.0, 0.4] {
+            let params = MorseTimingParams {
+                wpm: 23,
+                word_gap_multiplier: 1.3,
+                humanization_factor,
+                random_seed: 5,
+            };
+            for text in ["", "PARIS", "CQ  [SK]E[A R]X 73?", "[KN", "x]"] {
+                let elements = morse_timing(text, &params).unwrap();
+                let size = morse_size(text, &params, &audio_params).unwrap();
+
+                assert_eq!(size.elements, elements.len(), "{text}");
+                assert_eq!(morse_timing_size(text, &params).unwrap(), elements.len());
+                assert_eq!(
+                    size.samples,
+                    crate::audio::morse_audio(&elements, &audio_params)
+                        .unwrap()
+                        .len()
+                );
+                let duration: f64 = elements.iter().map(|e| e.duration_seconds as f64).sum();
+                assert!((size.duration_seconds - duration).abs() < 1e-9);
+            }
+        }
+    }
+
+    #[test]
+    fn test_symbols_retime_to_timing() {
+        let text = "CQ  [SK]E[A R]X 73?";
+        let symbols = morse_symbols(text);
+        assert_eq!(
+            symbols.len(),
+            morse_timing_size(text, &Default::default()).unwrap()
+        );
+
+        // The same symbols time to the same elements at any speed, humanized or not
+        let key = |e: &MorseElement| (e.element_type, e.duration_seconds.to_bits());
+        for (wpm, humanization_factor) in [(20, 0.0), (37, 0.0), (23, 0.4)] {
+            let params = MorseTimingParams {
+                wpm,
+                word_gap_multiplier: 1.3,
+                humanization_factor,
+                random_seed: 5,
+            };
+            let direct: Vec<_> = morse_timing(text, &params)
+                .unwrap()
+                .iter()
+                .map(key)
+                .collect();
+            let retimed: Vec<_> = morse_timing_from_symbols(&symbols, &params)
+                .unwrap()
+                .iter()
+                .map(key)
+                .collect();
+            assert_eq!(retimed, direct);
+        }
+
+        // One byte each on the wire
+        let json = serde_json::to_string(&symbols[..4]).unwrap();
+        assert_eq!(json, "[1,2,0,2]"); // C: dash, gap, dot, gap
+        let bytes: Vec<u8> = symbols.iter().map(|&s| u8::from(s)).collect();
+        let decoded: Result<Vec<_>, _> = bytes.iter().map(|&b| MorseSymbol::try_from(b)).collect();
+        assert_eq!(decoded.unwrap(), symbols);
+        assert!(MorseSymbol::try_from(5).is_err());
+        assert!(serde_json::from_str::<MorseSymbol>("9").is_err());
+    }
+
+    #[test]
+    fn test_humanization_is_counter_based() {
+        let text = "CQ CQ DE W1AW W1AW K";
+        let params = MorseTimingParams {
+            humanization_factor: 0.8,
+            random_seed: 7,
+            ..Default::default()
+        };
+        let key = |e: MorseElement| (e.element_type, e.duration_seconds.to_bits());
+        let elements: Vec<_> = morse_timing(text, &params)
+            .unwrap()
+            .into_iter()
+            .map(key)
+            .collect();
+
+        // Skipping elements still reads their symbols but draws no jitter for them, and lands
+        // on the same element: each draw depends only on its index
+        for k in [0, 1, 17, elements.len() - 1] {
+            let element = MorseTimingIter::new(text, &params).unwrap().nth(k).unwrap();
+            assert_eq!(key(element), elements[k]);
+        }
+        let mut iter = MorseTimingIter::new(text, &params).unwrap();
+        assert_eq!(key(iter.nth(3).unwrap()), elements[3]);
+        assert_eq!(key(iter.nth(5).unwrap()), elements[9]);
+
+        // Repeated text doesn't repeat its jitter
+        let cq = |k: usize| &elements[k * 16..k * 16 + 15]; // Each "CQ", without its word gap
+        assert_ne!(cq(0), cq(1));
+
+        // Jitter stays in bounds and varies, and another seed gives other jitter
+        let plain = morse_timing(text, &MorseTimingParams::default()).unwrap();
+        let human = morse_timing(text, &params).unwrap();
+        let ratios: Vec<_> = plain
+            .iter()
+            .zip(&human)
+            .map(|(p, h)| h.duration_seconds / p.duration_seconds)
+            .collect();
+        assert!(ratios
+            .iter()
+            .all(|&r| (0.1..=1.0 + HUMANIZATION_MAX_VARIANCE).contains(&r)));
+        assert!(ratios.iter().any(|&r| r < 0.95) && ratios.iter().any(|&r| r > 1.05));
+
+        let reseeded = MorseTimingParams {
+            random_seed: 8,
+            ..params
+        };
+        let other: Vec<_> = morse_timing(text, &reseeded)
+            .unwrap()
+            .into_iter()
+            .map(key)
+            .collect();
+        assert_ne!(other, elements);
+    }
+
+    #[cfg(feature = "parallel")]
+    #[test]
+    fn test_parallel_timing_matches_serial() {
+        let text = "CQ [A R] DE W1AW [SK]  K6ABC/P 73 [KN".repeat(40);
+        let key = |e: &MorseElement| (e.element_type, e.duration_seconds.to_bits());
+
+        for humanization_factor in [0.0, 0.6] {
+            let params = MorseTimingParams {
+                humanization_factor,
+                random_seed: 11,
+                ..Default::default()
+            };
+            let serial: Vec<_> = morse_timing(&text, &params)
+                .unwrap()
+                .iter()
+                .map(key)
+                .collect();
+
+            // Small chunks put cuts next to prosigns, double spaces and the open bracket
+            for chunk_bytes in [1, 9, 100, text.len()] {
+                let chunked: Vec<_> = timing_chunks(&text, &params, chunk_bytes)
+                    .unwrap()
+                    .iter()
+                    .map(key)
+                    .collect();
+                assert_eq!(chunked, serial, "{chunk_bytes}");
+            }
+            let parallel = morse_timing_parallel(&text, &params).unwrap();
+            assert_eq!(parallel.iter().map(key).collect::<Vec<_>>(), serial);
+        }
+    }
+
+    #[test]
+    fn test_session_edits_match_fresh_timing() {
+        let key = |e: &MorseElement| (e.element_type, e.duration_seconds.to_bits());
+        let pieces = ["E", "T ", " ", "[", "]", "AR", "SOS ", "é", "x", "[K N]"];
+
+        for humanization_factor in [0.0, 0.5] {
+            let params = MorseTimingParams {
+                humanization_factor,
+                random_seed: 21,
+                ..Default::default()
+            };
+            let mut session = MorseTimingSession::new("CQ DE [SK] W1AW", &params).unwrap();
+            let mut state = 1u32;
+            let mut next = |n: usize| {
+                state = state.wrapping_mul(1103515245).wrapping_add(12345);
+                (state >> 16) as usize % n.max(1)
+            };
+
+            for _ in 0..300 {
+                let old: Vec<_> = session.elements().iter().map(key).collect();
+                let len = session.text().len();
+                let (mut a, mut b) = (next(len + 1), next(len + 1));
+                if a > b {
+                    std::mem::swap(&mut a, &mut b);
+                }
+                let piece = pieces[next(pieces.len())];
+                let patch = match session.edit(a..b, piece) {
+                    Ok(patch) => patch,
+                    Err(_) => session.set_text(&format!("{piece}{}", session.text())),
+                };
+
+                let fresh = morse_timing(session.text(), &params).unwrap();
+                let fresh: Vec<_> = fresh.iter().map(key).collect();
+                assert_eq!(
+                    session.elements().iter().map(key).collect::<Vec<_>>(),
+                    fresh
+                );
+
+                // The patch describes exactly what changed
+                let mut patched = old.clone();
+                let inserted = &fresh[patch.start..patch.start + patch.inserted];
+                patched.splice(
+                    patch.start..patch.start + patch.removed,
+                    inserted.iter().copied(),
+                );
+                assert_eq!(patched, fresh);
+                let before: f64 = session.elements()[..patch.start]
+                    .iter()
+                    .map(|e| e.duration_seconds as f64)
+                    .sum();
+                assert_eq!(patch.start_seconds, before);
+            }
+
+            let total: f64 = session
+                .elements()
+                .iter()
+                .map(|e| e.duration_seconds as f64)
+                .sum();
+            assert_eq!(session.duration_seconds(), total);
+        }
+
+        // An edit at the end of a long text re-times only the end
+        let mut session =
+            MorseTimingSession::new(&"PARIS ".repeat(100), &Default::default()).unwrap();
+        let patch = session.set_text(&"PARIS ".repeat(101));
+        assert_eq!((patch.removed, patch.inserted), (0, 28));
+        let patch = session.edit(7..8, "N").unwrap(); // .- to -. in the second word
+        assert_eq!((patch.start, patch.removed, patch.inserted), (35, 4, 4));
+
+        // Humanized, an edit that keeps the element count stays local; one that changes it
+        // moves every later draw, so the rest of the text is re-timed
+        let params = MorseTimingParams {
+            humanization_factor: 0.1,
+            random_seed: 3,
+            ..Default::default()
+        };
+        let mut session = MorseTimingSession::new(&"PARIS ".repeat(100), &params).unwrap();
+        let total = session.elements().len();
+        let patch = session.edit(7..8, "N").unwrap();
+        assert_eq!((patch.start, patch.removed, patch.inserted), (35, 4, 4));
+        let patch = session.edit(0..0, "E").unwrap();
+        assert_eq!(
+            (patch.start, patch.removed, patch.inserted),
+            (0, total, total + 2)
+        );
+        let fresh = morse_timing(session.text(), &params).unwrap();
+        assert!(session.elements().iter().map(key).eq(fresh.iter().map(key)));
+    }
+
+    #[test]
+    fn test_batch_matches_single_timing() {
+        let key = |e: &MorseElement| (e.element_type, e.duration_seconds.to_bits());
+        let texts: Vec<String> = (0..700)
+            .map(|i| match i % 4 {
+                0 => format!("W{}ABC", i),
+                1 => format!("CQ DE K{} K", i),
+                2 => String::new(),
+                _ => format!("5NN {:03} [KN]", i),
+            })
+            .collect();
+        let params = MorseTimingParams {
+            humanization_factor: 0.3,
+            random_seed: 4,
+            ..Default::default()
+        };
+
+        let batch = morse_timing_batch(&texts, &params).unwrap();
+        assert_eq!(batch.len(), texts.len());
+        for (text, elements) in texts.iter().zip(batch.iter()) {
+            let single = morse_timing(text, &params).unwrap();
+            assert_eq!(
+                elements.iter().map(key).collect::<Vec<_>>(),
+                single.iter().map(key).collect::<Vec<_>>()
+            );
+        }
+        assert_eq!(
+            batch.get(1).unwrap().len(),
+            batch.offsets()[2] - batch.offsets()[1]
+        );
+        assert!(batch.get(texts.len()).is_none());
+
+        #[cfg(feature = "parallel")]
+        {
+            let parallel = morse_timing_batch_parallel(&texts, &params).unwrap();
+            assert_eq!(parallel.offsets(), batch.offsets());
+            assert!(parallel
+                .elements()
+                .iter()
+                .map(key)
+                .eq(batch.elements().iter().map(key)));
+        }
+
+        // A reused batch keeps its buffers
+        let mut reused = batch;
+        let buffer = reused.elements().as_ptr();
+        reused.time(&texts[..100], &params).unwrap();
+        assert_eq!(reused.elements().as_ptr(), buffer);
+        assert_eq!(reused.len(), 100);
+        assert!(reused
+            .time(&texts, &MorseTimingParams { wpm: 0, ..params })
+            .is_err());
+    }
+
+    #[test]
+    fn test_compile_time_encoding_matches_runtime() {
+        const BEACON: &[MorseSymbol] = crate::morse_symbols!("VVV DE W1AW/B [AR] 73");
+        let elements: &[MorseElement] = crate::morse_elements!("CQ  [SK] é?", 27, 1.4);
+
+        assert_eq!(BEACON, morse_symbols("VVV DE W1AW/B [AR] 73"));
+        let params = MorseTimingParams {
+            wpm: 27,
+            word_gap_multiplier: 1.4,
+            ..Default::default()
+        };
+        let key = |e: &MorseElement| (e.element_type, e.duration_seconds.to_bits());
+        let runtime = morse_timing("CQ  [SK] é?", &params).unwrap();
+        assert!(elements.iter().map(key).eq(runtime.iter().map(key)));
+        assert_eq!(crate::morse_elements!("", 20).len(), 0);
+    }
 }
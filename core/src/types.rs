@@ -1,6 +1,6 @@
 use serde::{Deserialize, Serialize};
 
-#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash, Serialize, Deserialize)]
 #[serde(rename_all = "lowercase")]
 pub enum MorseElementType {
     Dot,
@@ -8,7 +8,7 @@ pub enum MorseElementType {
     Gap,
 }
 
-#[derive(Debug, Clone, Serialize, Deserialize)]
+#[derive(Debug, Clone, Copy, Serialize, Deserialize)]
 #[serde(rename_all = "camelCase")]
 pub struct MorseElement {
     #[serde(rename = "type")]
@@ -16,6 +16,54 @@ pub struct MorseElement {
     pub duration_seconds: f32,
 }
 
+/// A timing element in one byte: its kind, with the duration left to the timing parameters.
+///
+/// Without humanization every element of a kind is equally long, so a text's symbols fully
+/// describe its timing at any speed and can be cached or shipped as bytes. Serialises as its
+/// byte value.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash, Serialize, Deserialize)]
+#[serde(into = "u8", try_from = "u8")]
+#[repr(u8)]
+pub enum MorseSymbol {
+    Dot,
+    Dash,
+    ElementGap, // Between the elements of a character, and between a prosign's characters
+    CharGap,
+    WordGap,
+}
+
+impl MorseSymbol {
+    /// The element type this symbol renders as
+    pub const fn element_type(self) -> MorseElementType {
+        match self {
+            Self::Dot => MorseElementType::Dot,
+            Self::Dash => MorseElementType::Dash,
+            _ => MorseElementType::Gap,
+        }
+    }
+}
+
+impl From<MorseSymbol> for u8 {
+    fn from(symbol: MorseSymbol) -> u8 {
+        symbol as u8
+    }
+}
+
+impl TryFrom<u8> for MorseSymbol {
+    type Error = String;
+
+    fn try_from(byte: u8) -> Result<Self, String> {
+        match byte {
+            0 => Ok(Self::Dot),
+            1 => Ok(Self::Dash),
+            2 => Ok(Self::ElementGap),
+            3 => Ok(Self::CharGap),
+            4 => Ok(Self::WordGap),
+            _ => Err(format!("Invalid morse symbol {}", byte)),
+        }
+    }
+}
+
 #[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
 #[serde(rename_all = "lowercase")]
 pub enum MorseAudioMode {
@@ -32,6 +80,14 @@ pub enum MorseWaveformType {
     Triangle,
 }
 
+// G.711 companding law for 8-bit telephony output
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
+#[serde(rename_all = "lowercase")]
+pub enum MorseG711Law {
+    Mulaw,
+    Alaw,
+}
+
 #[derive(Debug, Clone, Serialize, Deserialize)]
 #[serde(rename_all = "camelCase", default)]
 pub struct MorseTimingParams {
@@ -58,6 +114,7 @@ pub struct MorseRadioParams {
     pub freq_hz: f32,
     pub waveform_type: MorseWaveformType,
     pub background_static_level: f32,
+    pub channel: MorseChannelParams,
 }
 
 impl Default for MorseRadioParams {
@@ -66,6 +123,40 @@ impl Default for MorseRadioParams {
             freq_hz: 440.0,
             waveform_type: MorseWaveformType::Sine,
             background_static_level: 0.0,
+            channel: MorseChannelParams::default(),
+        }
+    }
+}
+
+// HF propagation and interference in radio mode; every impairment is off at its default
+#[derive(Debug, Clone, Serialize, Deserialize)]
+#[serde(rename_all = "camelCase", default)]
+pub struct MorseChannelParams {
+    pub fading_spread_hz: f32, // Watterson Doppler spread; 0 disables multipath fading
+    pub multipath_delay_ms: f32, // Delay of the second fading path; 0 for a single path
+    pub qsb_depth: f32,        // Depth of slow fading, 0 to 1
+    pub qsb_rate_hz: f32,
+    pub qrn_level: f32, // Peak level of static crashes
+    pub qrn_rate_hz: f32,
+    pub qrm_level: f32, // Level of an interfering CW signal
+    pub qrm_offset_hz: f32,
+    pub qrm_wpm: f32,
+    pub seed: u32,
+}
+
+impl Default for MorseChannelParams {
+    fn default() -> Self {
+        Self {
+            fading_spread_hz: 0.0,
+            multipath_delay_ms: 1.0,
+            qsb_depth: 0.0,
+            qsb_rate_hz: 0.1,
+            qrn_level: 0.0,
+            qrn_rate_hz: 2.0,
+            qrm_level: 0.0,
+            qrm_offset_hz: 300.0,
+            qrm_wpm: 25.0,
+            seed: 0,
         }
     }
 }
@@ -122,6 +213,58 @@ impl Default for MorseAudioParams {
     }
 }
 
+// One signal in a multi-station mix
+#[derive(Debug, Clone, Serialize, Deserialize)]
+#[serde(rename_all = "camelCase", default)]
+pub struct MorseStation {
+    pub text: String,
+    pub timing_params: MorseTimingParams,
+    pub freq_hz: f32,
+    pub level: f32,
+    pub start_seconds: f32,
+}
+
+impl Default for MorseStation {
+    fn default() -> Self {
+        Self {
+            text: String::new(),
+            timing_params: MorseTimingParams::default(),
+            freq_hz: 600.0,
+            level: 1.0,
+            start_seconds: 0.0,
+        }
+    }
+}
+
+// How a multi-station mix synthesises its carriers
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
+#[serde(rename_all = "lowercase")]
+pub enum MorseMixSynthesis {
+    /// One oscillator per station, exactly as in single-station rendering
+    Oscillator,
+    /// All carriers at once by inverse-FFT overlap-add; sine carriers only
+    Spectral,
+}
+
+// Exact size of a text's timing and audio, computed without generating either
+#[derive(Debug, Clone, Copy, PartialEq, Serialize, Deserialize)]
+#[serde(rename_all = "camelCase")]
+pub struct MorseSize {
+    pub elements: usize,
+    pub duration_seconds: f64,
+    pub samples: usize,
+}
+
+// Elements of a timing that an edit replaced
+#[derive(Debug, Clone, Copy, PartialEq, Serialize, Deserialize)]
+#[serde(rename_all = "camelCase")]
+pub struct MorseTimingPatch {
+    pub start: usize,       // Index of the first changed element
+    pub removed: usize,     // Old elements replaced from there
+    pub inserted: usize,    // New elements in their place
+    pub start_seconds: f64, // Time at which the first changed element starts
+}
+
 // Interpretation types (stubbed for now as requested)
 #[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct MorseSignal {
@@ -0,0 +1,384 @@
+// Streaming RIFF/WAVE output
+use crate::audio::MorseAudioStream;
+use crate::types::{MorseAudioParams, MorseElement};
+use std::io::{self, Seek, SeekFrom, Write};
+
+const WRITE_BLOCK: usize = 1024; // Samples rendered and converted per write
+const UNKNOWN_SIZE: u32 = u32::MAX; // Size field for streams of unknown length, as used by pipes
+
+/// Sample encoding of a WAV file
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum WavSampleFormat {
+    /// 32-bit IEEE float, exactly the rendered samples
+    Float32,
+    /// 16-bit signed PCM at full scale 32767, clipped. `write_stream` dithers rendered audio;
+    /// `write_f32` only rounds, so PCM read back as float writes back unchanged.
+    Pcm16,
+}
+
+impl WavSampleFormat {
+    fn bytes_per_sample(self) -> u32 {
+        match self {
+            WavSampleFormat::Float32 => 4,
+            WavSampleFormat::Pcm16 => 2,
+        }
+    }
+
+    fn format_tag(self) -> u16 {
+        match self {
+            WavSampleFormat::Float32 => 3, // WAVE_FORMAT_IEEE_FLOAT
+            WavSampleFormat::Pcm16 => 1,   // WAVE_FORMAT_PCM
+        }
+    }
+
+    // Non-PCM formats carry a cbSize field and a fact chunk
+    fn is_pcm(self) -> bool {
+        self == WavSampleFormat::Pcm16
+    }
+
+    fn header_len(self) -> u64 {
+        if self.is_pcm() {
+            44
+        } else {
+            58
+        }
+    }
+}
+
+/// Mono WAV writer that takes samples block by block, so messages of any length are written
+/// with constant memory.
+///
+/// The header is written up front. With `with_length` it carries the exact sizes; with `new` it
+/// carries the "unknown length" sizes that streaming readers accept, which `finish_seekable`
+/// patches once the real length is known.
+pub struct WavWriter<W: Write> {
+    writer: W,
+    format: WavSampleFormat,
+    sample_rate: u32,
+    declared_samples: Option<u64>,
+    samples_written: u64,
+}
+
+impl<W: Write> WavWriter<W> {
+    /// Start a file of unknown length
+    pub fn new(writer: W, sample_rate: u32, format: WavSampleFormat) -> io::Result<Self> {
+        Self::start(writer, sample_rate, format, None)
+    }
+
+    /// Start a file of exactly `samples` samples, for example `morse_audio_size` of a message
+    pub fn with_length(
+        writer: W,
+        sample_rate: u32,
+        format: WavSampleFormat,
+        samples: u64,
+    ) -> io::Result<Self> {
+        Self::start(writer, sample_rate, format, Some(samples))
+    }
+
+    fn start(
+        writer: W,
+        sample_rate: u32,
+        format: WavSampleFormat,
+        declared_samples: Option<u64>,
+    ) -> io::Result<Self> {
+        let mut wav = Self {
+            writer,
+            format,
+            sample_rate,
+            declared_samples,
+            samples_written: 0,
+        };
+
+        let header = wav.header(declared_samples);
+        wav.writer.write_all(&header)?;
+        Ok(wav)
+    }
+
+    /// Append float samples, rounded and clipped if the file is 16-bit
+    pub fn write_f32(&mut self, samples: &[f32]) -> io::Result<()> {
+        let mut bytes = [0; WRITE_BLOCK * 4];
+
+        for block in samples.chunks(WRITE_BLOCK) {
+            let len = match self.format {
+                WavSampleFormat::Float32 => {
+                    for (out, sample) in bytes.chunks_exact_mut(4).zip(block) {
+                        out.copy_from_slice(&sample.to_le_bytes());
+                    }
+                    block.len() * 4
+                }
+                WavSampleFormat::Pcm16 => {
+                    for (out, sample) in bytes.chunks_exact_mut(2).zip(block) {
+                        let pcm = (sample * 32767.0).round().clamp(-32768.0, 32767.0) as i16;
+                        out.copy_from_slice(&pcm.to_le_bytes());
+                    }
+                    block.len() * 2
+                }
+            };
+            self.write_bytes(&bytes[..len], block.len())?;
+        }
+
+        Ok(())
+    }
+
+    /// Append 16-bit samples, converting them at the scale `write_f32` uses if the file is float
+    pub fn write_pcm16(&mut self, samples: &[i16]) -> io::Result<()> {
+        let mut bytes = [0; WRITE_BLOCK * 4];
+
+        for block in samples.chunks(WRITE_BLOCK) {
+            let len = match self.format {
+                WavSampleFormat::Float32 => {
+                    for (out, &sample) in bytes.chunks_exact_mut(4).zip(block) {
+                        out.copy_from_slice(&(sample as f32 / 32767.0).to_le_bytes());
+                    }
+                    block.len() * 4
+                }
+                WavSampleFormat::Pcm16 => {
+                    for (out, sample) in bytes.chunks_exact_mut(2).zip(block) {
+                        out.copy_from_slice(&sample.to_le_bytes());
+                    }
+                    block.len() * 2
+                }
+            };
+            self.write_bytes(&bytes[..len], block.len())?;
+        }
+
+        Ok(())
+    }
+
+    /// Render the rest of `stream` into the file, one block at a time. 16-bit files use the
+    /// stream's dithered PCM output. Returns the number of samples written.
+    pub fn write_stream<I>(&mut self, stream: &mut MorseAudioStream<I>) -> io::Result<u64>
+    where
+        I: Iterator<Item = MorseElement>,
+    {
+        let start = self.samples_written;
+
+        loop {
+            let written = match self.format {
+                WavSampleFormat::Float32 => {
+                    let mut block = [0.0; WRITE_BLOCK];
+                    let written = stream.fill(&mut block);
+                    self.write_f32(&block[..written])?;
+                    written
+                }
+                WavSampleFormat::Pcm16 => {
+                    let mut block = [0; WRITE_BLOCK];
+                    let written = stream.fill_pcm16(&mut block);
+                    self.write_pcm16(&block[..written])?;
+                    written
+                }
+            };
+
+            if written < WRITE_BLOCK {
+                break;
+            }
+        }
+
+        Ok(self.samples_written - start)
+    }
+
+    /// Number of samples written so far
+    pub fn samples_written(&self) -> u64 {
+        self.samples_written
+    }
+
+    /// Flush and return the writer. Fails if a length given to `with_length` was not met.
+    pub fn finish(mut self) -> io::Result<W> {
+        if let Some(declared) = self.declared_samples {
+            if declared != self.samples_written {
+                return Err(io::Error::new(
+                    io::ErrorKind::InvalidData,
+                    format!(
+                        "WAV header declares {declared} samples but {} were written",
+                        self.samples_written
+                    ),
+                ));
+            }
+        }
+
+        self.writer.flush()?;
+        Ok(self.writer)
+    }
+
+    fn write_bytes(&mut self, bytes: &[u8], samples: usize) -> io::Result<()> {
+        self.writer.write_all(bytes)?;
+        self.samples_written += samples as u64;
+        Ok(())
+    }
+
+    // Header for `samples` samples, or with unknown sizes. Lengths too large for the 32-bit
+    // fields are also written as unknown.
+    fn header(&self, samples: Option<u64>) -> Vec<u8> {
+        let bytes_per_sample = self.format.bytes_per_sample();
+        let header_len = self.format.header_len();
+        let data_len = samples.map(|n| n * bytes_per_sample as u64);
+        let size = |len: Option<u64>| {
+            len.and_then(|len| u32::try_from(len).ok())
+                .unwrap_or(UNKNOWN_SIZE)
+        };
+
+        let mut header = Vec::with_capacity(header_len as usize);
+        header.extend_from_slice(b"RIFF");
+        header.extend_from_slice(&size(data_len.map(|len| len + header_len - 8)).to_le_bytes());
+        header.extend_from_slice(b"WAVE");
+
+        header.extend_from_slice(b"fmt ");
+        header.extend_from_slice(&(if self.format.is_pcm() { 16u32 } else { 18 }).to_le_bytes());
+        header.extend_from_slice(&self.format.format_tag().to_le_bytes());
+        header.extend_from_slice(&1u16.to_le_bytes()); // Mono
+        header.extend_from_slice(&self.sample_rate.to_le_bytes());
+        header.extend_from_slice(&(self.sample_rate * bytes_per_sample).to_le_bytes());
+        header.extend_from_slice(&(bytes_per_sample as u16).to_le_bytes()); // Block align
+        header.extend_from_slice(&(bytes_per_sample as u16 * 8).to_le_bytes());
+
+        if !self.format.is_pcm() {
+            header.extend_from_slice(&0u16.to_le_bytes()); // cbSize
+            header.extend_from_slice(b"fact");
+            header.extend_from_slice(&4u32.to_le_bytes());
+            header.extend_from_slice(&size(samples).to_le_bytes());
+        }
+
+        header.extend_from_slice(b"data");
+        header.extend_from_slice(&size(data_len).to_le_bytes());
+        header
+    }
+}
+
+impl<W: Write + Seek> WavWriter<W> {
+    /// Rewrite the header with the number of samples actually written, then flush and return
+    /// the writer positioned at the end of the file
+    pub fn finish_seekable(mut self) -> io::Result<W> {
+        let header = self.header(Some(self.samples_written));
+        let data_len = self.samples_written * self.format.bytes_per_sample() as u64;
+        let end = self.writer.stream_position()?;
+
+        // The file may not start at offset zero of the writer
+        self.writer
+            .seek(SeekFrom::Start(end - data_len - header.len() as u64))?;
+        self.writer.write_all(&header)?;
+        self.writer.seek(SeekFrom::Start(end))?;
+        self.writer.flush()?;
+        Ok(self.writer)
+    }
+}
+
+/// Render timing elements straight to a WAV file with the exact length in its header, using
+/// memory independent of the message length. Returns the writer.
+pub fn morse_audio_wav<W: Write>(
+    events: &[MorseElement],
+    params: &MorseAudioParams,
+    format: WavSampleFormat,
+    writer: W,
+) -> Result<W, String> {
+    let samples = crate::audio::morse_audio_size(events, params)?;
+    let mut stream = MorseAudioStream::new(events, params)?;
+    let io_error = |e: io::Error| format!("WAV write failed: {e}");
+
+    let mut wav = WavWriter::with_length(writer, params.sample_rate as u32, format, samples as u64)
+        .map_err(io_error)?;
+    wav.write_stream(&mut stream).map_err(io_error)?;
+    wav.finish().map_err(io_error)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::audio::{morse_audio, morse_audio_pcm16};
+    use crate::timing::morse_timing;
+    use crate::types::MorseTimingParams;
+    use std::io::Cursor;
+
+    fn read_u32(bytes: &[u8], at: usize) -> u32 {
+        u32::from_le_bytes(bytes[at..at + 4].try_into().unwrap())
+    }
+
+    #[test]
+    fn test_wav_matches_batch_render() {
+        let events = morse_timing("CQ DE W1AW", &MorseTimingParams::default()).unwrap();
+        let params = MorseAudioParams::default();
+
+        let float = morse_audio(&events, &params).unwrap();
+        let bytes =
+            morse_audio_wav(&events, &params, WavSampleFormat::Float32, Vec::new()).unwrap();
+        assert_eq!(&bytes[..4], b"RIFF");
+        assert_eq!(read_u32(&bytes, 4) as usize, bytes.len() - 8);
+        assert_eq!(&bytes[50..54], b"data");
+        assert_eq!(read_u32(&bytes, 46) as usize, float.len());
+        let decoded: Vec<f32> = bytes[58..]
+            .chunks_exact(4)
+            .map(|b| f32::from_le_bytes(b.try_into().unwrap()))
+            .collect();
+        assert_eq!(decoded, float);
+
+        let pcm = morse_audio_pcm16(&events, &params).unwrap();
+        let bytes = morse_audio_wav(&events, &params, WavSampleFormat::Pcm16, Vec::new()).unwrap();
+        assert_eq!(read_u32(&bytes, 40) as usize, pcm.len() * 2);
+        let decoded: Vec<i16> = bytes[44..]
+            .chunks_exact(2)
+            .map(|b| i16::from_le_bytes(b.try_into().unwrap()))
+            .collect();
+        assert_eq!(decoded, pcm);
+    }
+
+    #[test]
+    fn test_wav_unknown_length_and_patching() {
+        let samples = [0.0, 0.5, -0.5, 1.0];
+
+        let mut piped = WavWriter::new(Vec::new(), 8000, WavSampleFormat::Pcm16).unwrap();
+        piped.write_f32(&samples).unwrap();
+        let bytes = piped.finish().unwrap();
+        assert_eq!(read_u32(&bytes, 4), UNKNOWN_SIZE);
+        assert_eq!(read_u32(&bytes, 40), UNKNOWN_SIZE);
+        assert_eq!(bytes.len(), 44 + 8);
+
+        // A file written after other data is patched in place
+        let mut cursor = Cursor::new(vec![7; 3]);
+        cursor.set_position(3);
+        let mut seekable = WavWriter::new(cursor, 8000, WavSampleFormat::Pcm16).unwrap();
+        seekable.write_f32(&samples).unwrap();
+        let bytes = seekable.finish_seekable().unwrap().into_inner();
+        assert_eq!(bytes[..3], [7; 3]);
+        assert_eq!(read_u32(&bytes, 3 + 4), 36 + 8);
+        assert_eq!(read_u32(&bytes, 3 + 40), 8);
+        assert_eq!(bytes[3..], piped_with_sizes(&samples));
+
+        let mut short =
+            WavWriter::with_length(Vec::new(), 8000, WavSampleFormat::Pcm16, 5).unwrap();
+        short.write_f32(&samples).unwrap();
+        assert!(short.finish().is_err());
+    }
+
+    #[test]
+    fn test_wav_pcm_round_trips_through_float() {
+        let pcm: Vec<i16> = (i16::MIN..=i16::MAX).step_by(7).chain([i16::MAX]).collect();
+
+        let mut float = WavWriter::new(Vec::new(), 8000, WavSampleFormat::Float32).unwrap();
+        float.write_pcm16(&pcm).unwrap();
+        let bytes = float.finish().unwrap();
+        let samples: Vec<f32> = bytes[58..]
+            .chunks_exact(4)
+            .map(|b| f32::from_le_bytes(b.try_into().unwrap()))
+            .collect();
+
+        let mut wav = WavWriter::new(Vec::new(), 8000, WavSampleFormat::Pcm16).unwrap();
+        wav.write_f32(&samples).unwrap();
+        let bytes = wav.finish().unwrap();
+        let decoded: Vec<i16> = bytes[44..]
+            .chunks_exact(2)
+            .map(|b| i16::from_le_bytes(b.try_into().unwrap()))
+            .collect();
+        assert_eq!(decoded, pcm);
+    }
+
+    fn piped_with_sizes(samples: &[f32]) -> Vec<u8> {
+        let mut wav = WavWriter::with_length(
+            Vec::new(),
+            8000,
+            WavSampleFormat::Pcm16,
+            samples.len() as u64,
+        )
+        .unwrap();
+        wav.write_f32(samples).unwrap();
+        wav.finish().unwrap()
+    }
+}